@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    AudioRing.cpp
+    Created: 16 Oct 2026 10:12:40am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "AudioRing.h"
+
+AudioRing::AudioRing()
+{
+}
+
+AudioRing::~AudioRing()
+{
+}
+
+void
+AudioRing::allocate(int numChannels,    // IN
+                    int sampleCapacity, // IN
+                    int blockCapacity)  // IN
+{
+    /*
+     * AbstractFifo keeps one slot empty to tell full from empty.
+     */
+    samples.setSize(numChannels, sampleCapacity + 1);
+    samples.clear();
+    sampleFifo.setTotalSize(sampleCapacity + 1);
+    sampleFifo.reset();
+
+    blocks.assign(blockCapacity + 1, BlockInfo());
+    blockFifo.setTotalSize(blockCapacity + 1);
+    blockFifo.reset();
+}
+
+void
+AudioRing::release()
+{
+    samples.setSize(0, 0);
+    sampleFifo.reset();
+    blocks.clear();
+    blockFifo.reset();
+}
+
+/*
+ * AudioRing::push
+ *    Copies a block of audio into the ring. Returns false (and drops
+ *    the block) if the consumer hasn't made enough room.
+ */
+bool
+AudioRing::push(double timestamp,                       // IN
+                double sampleRate,                      // IN
+                const juce::AudioBuffer<float> &buffer) // IN
+{
+    const int numSamples = buffer.getNumSamples();
+
+    if (blocks.empty() ||
+        blockFifo.getFreeSpace() < 1 ||
+        sampleFifo.getFreeSpace() < numSamples) {
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    sampleFifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < samples.getNumChannels(); ch++) {
+        if (buffer.getNumChannels() == 0) {
+            samples.clear(ch, start1, size1);
+            samples.clear(ch, start2, size2);
+            continue;
+        }
+
+        // Mono input feeds every channel
+        int srcCh = juce::jmin(ch, buffer.getNumChannels() - 1);
+        samples.copyFrom(ch, start1, buffer, srcCh, 0, size1);
+        if (size2 > 0) {
+            samples.copyFrom(ch, start2, buffer, srcCh, size1, size2);
+        }
+    }
+
+    sampleFifo.finishedWrite(size1 + size2);
+
+    /*
+     * The block header is published last so the consumer never sees
+     * a block whose samples haven't been written.
+     */
+    blockFifo.prepareToWrite(1, start1, size1, start2, size2);
+    blocks[start1].timestamp = timestamp;
+    blocks[start1].sampleRate = sampleRate;
+    blocks[start1].numSamples = numSamples;
+    blockFifo.finishedWrite(1);
+
+    return true;
+}
+
+/*
+ * AudioRing::pop
+ *    Reads the oldest block out of the ring. The destination buffer is
+ *    resized to fit the block. Returns false if the ring is empty.
+ */
+bool
+AudioRing::pop(BlockInfo &info,                  // OUT
+               juce::AudioBuffer<float> &buffer) // OUT
+{
+    if (blockFifo.getNumReady() < 1) {
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    blockFifo.prepareToRead(1, start1, size1, start2, size2);
+    info = blocks[start1];
+    blockFifo.finishedRead(1);
+
+    buffer.setSize(samples.getNumChannels(), info.numSamples, false, false, true);
+
+    sampleFifo.prepareToRead(info.numSamples, start1, size1, start2, size2);
+    for (int ch = 0; ch < samples.getNumChannels(); ch++) {
+        buffer.copyFrom(ch, 0, samples, ch, start1, size1);
+        if (size2 > 0) {
+            buffer.copyFrom(ch, size1, samples, ch, start2, size2);
+        }
+    }
+    sampleFifo.finishedRead(size1 + size2);
+
+    return true;
+}
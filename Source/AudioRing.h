@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    AudioRing.h
+    Created: 16 Oct 2026 10:12:40am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+ * AudioRing
+ *    Wait-free single-producer / single-consumer queue of audio blocks.
+ *    The audio thread pushes each processBlock buffer along with its
+ *    timestamp, and the render thread pops them at its own pace. The
+ *    producer never blocks or spins: if the consumer has fallen behind
+ *    and there is no room left, the block is dropped and push returns
+ *    false for the caller to count.
+ */
+class AudioRing
+{
+public:
+    struct BlockInfo
+    {
+        double timestamp = 0.0;
+        double sampleRate = 0.0;
+        int numSamples = 0;
+    };
+
+    AudioRing();
+    ~AudioRing();
+
+    /*
+     * Not realtime safe. Must not be called while a producer or
+     * consumer is active.
+     */
+    void allocate(int numChannels, int sampleCapacity, int blockCapacity);
+    void release();
+
+    /*
+     * Producer side (audio thread)
+     */
+    bool push(double timestamp, double sampleRate,
+              const juce::AudioBuffer<float> &buffer);
+
+    /*
+     * Consumer side (render thread)
+     */
+    bool pop(BlockInfo &info, juce::AudioBuffer<float> &buffer);
+
+private:
+    juce::AbstractFifo sampleFifo { 1 };
+    juce::AbstractFifo blockFifo { 1 };
+    juce::AudioBuffer<float> samples;
+    std::vector<BlockInfo> blocks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioRing)
+};
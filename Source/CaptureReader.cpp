@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    CaptureReader.cpp
+    Created: 17 Oct 2026 1:58:12am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "CaptureReader.h"
+
+CaptureReader::CaptureReader()
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+}
+
+bool
+CaptureReader::open(const juce::File &captureFile, // IN
+                    juce::String &error)           // OUT
+{
+    file = captureFile;
+    numParameters = 0;
+    numBlocksDropped = 0;
+
+    std::unique_ptr<juce::FileInputStream> in(new juce::FileInputStream(file));
+    if (!in->openedOk()) {
+        error = "Could not open " + file.getFullPathName() + ": " +
+                in->getStatus().getErrorMessage();
+        return false;
+    }
+
+    input.reset(new juce::BufferedInputStream(in.release(), 1 << 16, true));
+
+    juce::uint32 magic = (juce::uint32)input->readInt();
+    juce::uint32 version = (juce::uint32)input->readInt();
+    int parameters = input->readInt();
+
+    if (magic != MAGIC) {
+        error = file.getFullPathName() + " is not an input capture";
+        return false;
+    }
+    if (version != VERSION) {
+        error = file.getFullPathName() + " is a capture version this build can't read (" +
+                juce::String(version) + ")";
+        return false;
+    }
+    if (parameters < 0 || parameters > MAX_PARAMETERS) {
+        error = file.getFullPathName() + " is corrupt";
+        return false;
+    }
+
+    numParameters = parameters;
+    return true;
+}
+
+/*
+ * CaptureReader::readBlock
+ *    A record cut short, as the last one of a capture that wasn't
+ *    stopped cleanly may be, ends the capture.
+ */
+CaptureReader::Result
+CaptureReader::readBlock(Block &block,                   // OUT
+                         std::vector<float> &parameters, // IN / OUT
+                         juce::String &error)            // OUT
+{
+    jassert(input != nullptr);
+
+    if ((int)parameters.size() < numParameters) {
+        parameters.resize((size_t)numParameters, 0.0f);
+    }
+
+    for (;;) {
+        if (input->getTotalLength() - input->getPosition() < 5) {
+            return RESULT_END;
+        }
+
+        int type = (juce::uint8)input->readByte();
+        juce::uint32 payloadSize = (juce::uint32)input->readInt();
+        juce::int64 payloadStart = input->getPosition();
+        if (input->getTotalLength() - payloadStart < (juce::int64)payloadSize) {
+            return RESULT_END;
+        }
+
+        switch (type) {
+        case RECORD_PARAMETERS:
+            if (!readParameters(payloadSize, parameters, error)) {
+                return RESULT_ERROR;
+            }
+            break;
+        case RECORD_BLOCK:
+            if (!readAudioBlock(payloadSize, block, error)) {
+                return RESULT_ERROR;
+            }
+            return RESULT_BLOCK;
+        case RECORD_GAP:
+            numBlocksDropped += input->readInt();
+            break;
+        default:
+            break;
+        }
+
+        input->setPosition(payloadStart + payloadSize);
+    }
+}
+
+bool
+CaptureReader::readParameters(juce::uint32 payloadSize,       // IN
+                              std::vector<float> &parameters, // IN / OUT
+                              juce::String &error)            // OUT
+{
+    juce::uint32 count = (juce::uint32)input->readInt();
+    if ((juce::uint64)count * 8 + 4 > payloadSize) {
+        error = file.getFullPathName() + " is corrupt";
+        return false;
+    }
+
+    for (juce::uint32 i = 0; i < count; i++) {
+        int idx = input->readInt();
+        float value = input->readFloat();
+
+        if (idx >= 0 && idx < (int)parameters.size()) {
+            parameters[(size_t)idx] = juce::jlimit(0.0f, 1.0f, value);
+        }
+    }
+
+    return true;
+}
+
+bool
+CaptureReader::readAudioBlock(juce::uint32 payloadSize, // IN
+                              Block &block,             // OUT
+                              juce::String &error)      // OUT
+{
+    block.timestamp = input->readDouble();
+    block.sampleRate = input->readDouble();
+    int numChannels = input->readInt();
+    int numSamples = input->readInt();
+    int numEvents = input->readInt();
+
+    const juce::uint64 sampleBytes = (juce::uint64)juce::jmax(0, numChannels) *
+                                     juce::jmax(0, numSamples) * sizeof(float);
+    if (block.sampleRate <= 0.0 || numChannels < 0 || numChannels > MAX_CHANNELS ||
+        numSamples < 0 || numSamples > MAX_BLOCK_SAMPLES || numEvents < 0 ||
+        28 + sampleBytes + (juce::uint64)numEvents * 8 > payloadSize) {
+        error = file.getFullPathName() + " is corrupt";
+        return false;
+    }
+
+    block.buffer.setSize(numChannels, numSamples, false, false, true);
+    for (int ch = 0; ch < numChannels; ch++) {
+        float *samples = block.buffer.getWritePointer(ch);
+        input->read(samples, numSamples * (int)sizeof(float));
+
+#if JUCE_BIG_ENDIAN
+        for (int i = 0; i < numSamples; i++) {
+            juce::uint32 bits;
+            memcpy(&bits, samples + i, sizeof(bits));
+            bits = juce::ByteOrder::swap(bits);
+            memcpy(samples + i, &bits, sizeof(bits));
+        }
+#endif
+    }
+
+    block.midiBuffer.clear();
+    for (int i = 0; i < numEvents; i++) {
+        int samplePos = input->readInt();
+        int size = input->readInt();
+        if (size < 0 || size > (int)payloadSize) {
+            error = file.getFullPathName() + " is corrupt";
+            return false;
+        }
+
+        if ((size_t)size > midiDataSize) {
+            midiData.realloc((size_t)size);
+            midiDataSize = (size_t)size;
+        }
+
+        input->read(midiData.get(), size);
+        block.midiBuffer.addEvent(midiData.get(), size, juce::jlimit(0, numSamples, samplePos));
+    }
+
+    return true;
+}
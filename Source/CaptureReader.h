@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    CaptureReader.h
+    Created: 17 Oct 2026 1:58:12am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ * CaptureReader
+ *    Reads back an input capture made by InputRecorder: every audio
+ *    block the processor received, with its midi and the parameter
+ *    values in effect, so a patch can be rendered again from exactly
+ *    the same input.
+ *
+ *    The file is little-endian: a header (MAGIC, VERSION, the number of
+ *    parameters) and then records, each a type byte and a payload size
+ *    so unknown records can be skipped:
+ *
+ *      RECORD_PARAMETERS  count, then count x (index, normalised value)
+ *                         for parameters changed since the last block;
+ *                         every parameter before the first block
+ *      RECORD_BLOCK       timestamp, sample rate, channels, samples,
+ *                         midi event count, samples channel by channel
+ *                         as float32, then (sample position, size,
+ *                         bytes) per midi event
+ *      RECORD_GAP         number of blocks the recorder had to drop
+ */
+class CaptureReader
+{
+public:
+    struct Block
+    {
+        double timestamp = 0.0;
+        double sampleRate = 0.0;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midiBuffer;
+    };
+
+    enum Result {
+        RESULT_BLOCK,
+        RESULT_END,
+        RESULT_ERROR
+    };
+
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const juce::File &file, juce::String &error);
+
+    /*
+     * Reads up to and including the next audio block. Parameter records
+     * on the way are applied to parameters, which is resized to hold
+     * every parameter in the capture.
+     */
+    Result readBlock(Block &block, std::vector<float> &parameters, juce::String &error);
+
+    int getNumParameters() const { return numParameters; }
+    int getNumBlocksDropped() const { return numBlocksDropped; }
+
+    static constexpr juce::uint32 MAGIC = 0x50435453; // "STCP"
+    static constexpr juce::uint32 VERSION = 1;
+
+    enum RecordType {
+        RECORD_PARAMETERS = 1,
+        RECORD_BLOCK,
+        RECORD_GAP
+    };
+
+    /*
+     * Sanity limits, so a corrupt file fails instead of allocating
+     * gigabytes.
+     */
+    static constexpr int MAX_CHANNELS = 64;
+    static constexpr int MAX_BLOCK_SAMPLES = 1 << 20;
+    static constexpr int MAX_PARAMETERS = 1 << 16;
+
+private:
+    bool readParameters(juce::uint32 payloadSize, std::vector<float> &parameters,
+                        juce::String &error);
+    bool readAudioBlock(juce::uint32 payloadSize, Block &block, juce::String &error);
+
+    juce::File file;
+    std::unique_ptr<juce::InputStream> input;
+    int numParameters = 0;
+    int numBlocksDropped = 0;
+    juce::HeapBlock<juce::uint8> midiData;
+    size_t midiDataSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CaptureReader)
+};
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    FrameProfiler.cpp
+    Created: 16 Oct 2026 9:22:47pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "FrameProfiler.h"
+
+FrameProfiler::FrameProfiler()
+ : history(HISTORY_FRAMES)
+{
+}
+
+FrameProfiler::~FrameProfiler()
+{
+}
+
+void
+FrameProfiler::reset()
+{
+    const juce::SpinLock::ScopedLockType scopedLock(lock);
+    numFrames = 0;
+}
+
+void
+FrameProfiler::addFrame(juce::uint64 number, // IN
+                        double timestamp,    // IN
+                        double cpuMs,        // IN
+                        double uniformMs)    // IN
+{
+    const juce::SpinLock::ScopedLockType scopedLock(lock);
+    Frame &frame = history[number % HISTORY_FRAMES];
+
+    latestNumber = number;
+    frame.number = number;
+    frame.timestamp = timestamp;
+    frame.cpuMs = (float)cpuMs;
+    frame.uniformMs = (float)uniformMs;
+    for (float &gpuMs : frame.gpuMs) {
+        gpuMs = -1.0f;
+    }
+
+    numFrames++;
+}
+
+FrameProfiler::Frame *
+FrameProfiler::findFrame(juce::uint64 number) // IN
+{
+    Frame &frame = history[number % HISTORY_FRAMES];
+    return numFrames > 0 && frame.number == number ? &frame : nullptr;
+}
+
+void
+FrameProfiler::addGpuTimes(const PassTimer &timer) // IN
+{
+    const juce::SpinLock::ScopedLockType scopedLock(lock);
+    Frame *frame = findFrame(timer.getCollectedFrame());
+
+    if (frame == nullptr) {
+        return;
+    }
+
+    for (int i = 0; i < PassTimer::MAX_PASSES; i++) {
+        if (timer.hasPassTime(i)) {
+            frame->gpuMs[i] = (float)(timer.getPassTime(i) * 1000.0);
+        }
+    }
+}
+
+void
+FrameProfiler::getSnapshot(std::vector<Frame> &frames, // OUT
+                           int maxFrames) const        // IN
+{
+    maxFrames = juce::jlimit(0, (int)HISTORY_FRAMES, maxFrames);
+    frames.clear();
+    frames.reserve(maxFrames); // Not under the lock
+
+    const juce::SpinLock::ScopedLockType scopedLock(lock);
+    juce::uint64 count = juce::jmin((juce::uint64)maxFrames, numFrames);
+
+    for (juce::uint64 number = latestNumber + 1 - count; number <= latestNumber && count > 0;
+         number++) {
+        frames.push_back(history[number % HISTORY_FRAMES]);
+    }
+}
+
+/*
+ * FrameProfiler::exportCsv
+ *    One row per frame, one GPU column per pass that was rendered at
+ *    least once in the exported range. Passes skipped in a frame (or
+ *    whose timing isn't known yet) are left empty.
+ */
+bool
+FrameProfiler::exportCsv(const juce::File &file,              // IN
+                         const juce::StringArray &names) const // IN
+{
+    std::vector<Frame> frames;
+    getSnapshot(frames, HISTORY_FRAMES);
+
+    std::vector<int> passes;
+    for (int i = 0; i < PassTimer::MAX_PASSES; i++) {
+        for (auto &frame : frames) {
+            if (frame.gpuMs[i] >= 0.0f) {
+                passes.push_back(i);
+                break;
+            }
+        }
+    }
+
+    juce::String csv = "frame,time_s,cpu_ms,uniform_upload_ms";
+    for (int i : passes) {
+        csv << ",gpu_ms " << (i < names.size() ? names[i] : juce::String(i));
+    }
+    csv << "\n";
+
+    for (auto &frame : frames) {
+        csv << juce::String((juce::int64)frame.number) << ","
+            << juce::String(frame.timestamp, 6) << ","
+            << juce::String(frame.cpuMs, 4) << ","
+            << juce::String(frame.uniformMs, 4);
+        for (int i : passes) {
+            csv << ",";
+            if (frame.gpuMs[i] >= 0.0f) {
+                csv << juce::String(frame.gpuMs[i], 4);
+            }
+        }
+        csv << "\n";
+    }
+
+    return file.replaceWithText(csv);
+}
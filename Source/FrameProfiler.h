@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    FrameProfiler.h
+    Created: 16 Oct 2026 9:22:47pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PassTimer.h"
+
+/*
+ * FrameProfiler
+ *    Keeps the last HISTORY_FRAMES frames of timing: CPU time spent in
+ *    the render callback, CPU time spent uploading uniforms, and GPU time
+ *    per pass. The render thread records, the message thread reads
+ *    snapshots for display and export. GPU times arrive a few frames
+ *    late (see PassTimer) and are filed under the frame they measured.
+ *
+ *    Only plain numbers are kept, so the lock the render thread takes
+ *    every frame is never held across an allocation. Pass names are
+ *    looked up by the reader, so renamed buffers show up right away.
+ */
+class FrameProfiler
+{
+public:
+    struct Frame
+    {
+        juce::uint64 number = 0;
+        double timestamp = 0.0; // Seconds
+        float cpuMs = 0.0f;
+        float uniformMs = 0.0f;
+        float gpuMs[PassTimer::MAX_PASSES]; // < 0 if not rendered / unknown
+    };
+
+    FrameProfiler();
+    ~FrameProfiler();
+
+    /*
+     * Render thread.
+     */
+    void reset();
+    void addFrame(juce::uint64 number, double timestamp, double cpuMs, double uniformMs);
+    void addGpuTimes(const PassTimer &timer);
+
+    /*
+     * Message thread. Frames come back oldest first. passNames is
+     * indexed by pass id.
+     */
+    void getSnapshot(std::vector<Frame> &frames, int maxFrames) const;
+    bool exportCsv(const juce::File &file, const juce::StringArray &passNames) const;
+
+    static constexpr int HISTORY_FRAMES = 1024;
+
+private:
+    Frame *findFrame(juce::uint64 number);
+
+    mutable juce::SpinLock lock; // Held only while copying
+    std::vector<Frame> history;  // Ring indexed by frame number
+    juce::uint64 numFrames = 0;  // Recorded since reset
+    juce::uint64 latestNumber = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameProfiler)
+};
@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    FrameReadback.cpp
+    Created: 17 Oct 2026 12:14:51am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "FrameReadback.h"
+
+FrameReadback::FrameReadback(juce::OpenGLContext &glContext) // IN
+ : juce::Thread("Frame Readback"),
+   glContext(glContext)
+{
+}
+
+FrameReadback::~FrameReadback()
+{
+    // release must have been called with the context current
+    jassert(!isThreadRunning());
+    stopThread(1000);
+}
+
+bool
+FrameReadback::initialise(int numBuffers) // IN
+{
+    glFenceSync = (PFNGLFENCESYNCPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glFenceSync");
+    glDeleteSync = (PFNGLDELETESYNCPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glDeleteSync");
+    glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glClientWaitSync");
+    glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glMapBufferRange");
+    glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glUnmapBuffer");
+
+    available = glFenceSync != nullptr && glDeleteSync != nullptr &&
+                glClientWaitSync != nullptr && glMapBufferRange != nullptr &&
+                glUnmapBuffer != nullptr;
+    if (!available) {
+        return false;
+    }
+
+    numSlots = juce::jlimit(MIN_BUFFERS, MAX_BUFFERS, numBuffers);
+    for (int i = 0; i < numSlots; i++) {
+        Slot &slot = slots[i];
+        glContext.extensions.glGenBuffers(1, &slot.buffer);
+        slot.capacity = 0;
+        slot.fence = nullptr;
+        slot.mapped = false;
+        slot.frame = Frame();
+        slot.state = SLOT_FREE;
+    }
+
+    nextCapture = 0;
+    nextMap = 0;
+    nextDeliver = 0;
+    numDropped = 0;
+    slotMapped.reset();
+    slotConsumed.reset();
+
+    startThread();
+    return true;
+}
+
+void
+FrameReadback::release()
+{
+    // The worker finishes the frame it is on, if any, before we unmap
+    stopThread(10000);
+
+    if (!available) {
+        return;
+    }
+
+    for (int i = 0; i < numSlots; i++) {
+        Slot &slot = slots[i];
+
+        unmapSlot(slot);
+        if (slot.fence != nullptr) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+
+        glContext.extensions.glDeleteBuffers(1, &slot.buffer);
+        slot.buffer = 0;
+        slot.capacity = 0;
+        slot.state = SLOT_FREE;
+    }
+
+    numSlots = 0;
+    available = false;
+}
+
+/*
+ * FrameReadback::capture
+ *    Issues the readback into the next buffer of the ring. glReadPixels
+ *    into a bound pack buffer returns as soon as the copy is queued.
+ */
+bool
+FrameReadback::capture(GLuint framebuffer,        // IN
+                       int width,                 // IN
+                       int height,                // IN
+                       juce::uint64 frameNumber,  // IN
+                       bool blocking)             // IN
+{
+    if (!available) {
+        return false;
+    }
+
+    Slot &slot = slots[nextCapture];
+    if (!waitForSlot(slot, blocking)) {
+        numDropped++;
+        return false;
+    }
+
+    width = juce::jmax(0, width);
+    height = juce::jmax(0, height);
+    GLsizeiptr size = (GLsizeiptr)width * height * 4;
+
+    glContext.extensions.glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (size > slot.capacity) {
+        glContext.extensions.glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.capacity = size;
+    }
+
+    if (size > 0) {
+        glContext.extensions.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glContext.extensions.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.frame.pixels = nullptr;
+    slot.frame.width = width;
+    slot.frame.height = height;
+    slot.frame.number = frameNumber;
+    slot.state = SLOT_PENDING;
+
+    nextCapture = (nextCapture + 1) % numSlots;
+    return true;
+}
+
+/*
+ * FrameReadback::waitForSlot
+ *    Gets the next capture buffer free. A buffer still pending here means
+ *    the ring has wrapped, so it is the oldest capture and is mapped
+ *    (waiting on its fence) to keep delivery in order.
+ */
+bool
+FrameReadback::waitForSlot(Slot &slot,    // IN / OUT
+                           bool blocking) // IN
+{
+    for (;;) {
+        switch (slot.state.load()) {
+        case SLOT_FREE:
+            return true;
+        case SLOT_CONSUMED:
+            unmapSlot(slot);
+            return true;
+        case SLOT_PENDING:
+            jassert(&slot == &slots[nextMap]);
+            mapSlot(slot, true);
+            nextMap = (nextMap + 1) % numSlots;
+            break;
+        default:
+            if (!blocking) {
+                return false;
+            }
+            slotConsumed.wait(50);
+            break;
+        }
+    }
+}
+
+void
+FrameReadback::poll()
+{
+    if (!available) {
+        return;
+    }
+
+    while (slots[nextMap].state.load() == SLOT_PENDING) {
+        Slot &slot = slots[nextMap];
+        if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+
+        mapSlot(slot, false);
+        nextMap = (nextMap + 1) % numSlots;
+    }
+
+    for (int i = 0; i < numSlots; i++) {
+        if (slots[i].state.load() == SLOT_CONSUMED) {
+            unmapSlot(slots[i]);
+        }
+    }
+}
+
+void
+FrameReadback::flush()
+{
+    if (!available) {
+        return;
+    }
+
+    while (slots[nextMap].state.load() == SLOT_PENDING) {
+        mapSlot(slots[nextMap], true);
+        nextMap = (nextMap + 1) % numSlots;
+    }
+
+    for (int i = 0; i < numSlots; i++) {
+        while (slots[i].state.load() == SLOT_MAPPED && isThreadRunning()) {
+            slotConsumed.wait(50);
+        }
+
+        if (slots[i].state.load() == SLOT_CONSUMED) {
+            unmapSlot(slots[i]);
+        }
+    }
+}
+
+/*
+ * FrameReadback::mapSlot
+ *    Maps a pending capture and hands it to the worker. If wait is set
+ *    the fence is waited on (flushing it first, so it is sure to
+ *    signal); otherwise the caller has already seen it pass.
+ */
+void
+FrameReadback::mapSlot(Slot &slot, // IN / OUT
+                       bool wait)  // IN
+{
+    if (wait) {
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    }
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    GLsizeiptr size = (GLsizeiptr)slot.frame.width * slot.frame.height * 4;
+    if (size > 0) {
+        glContext.extensions.glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        slot.frame.pixels = (const juce::uint8 *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size,
+                                                                  GL_MAP_READ_BIT);
+        glContext.extensions.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.mapped = slot.frame.pixels != nullptr;
+        if (!slot.mapped) {
+            numDropped++;
+        }
+    }
+
+    slot.state = SLOT_MAPPED;
+    slotMapped.signal();
+}
+
+void
+FrameReadback::unmapSlot(Slot &slot) // IN / OUT
+{
+    if (slot.mapped) {
+        glContext.extensions.glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glContext.extensions.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.mapped = false;
+    }
+
+    slot.frame.pixels = nullptr;
+    slot.state = SLOT_FREE;
+}
+
+/*
+ * FrameReadback::run
+ *    Delivers mapped frames in ring order, which is capture order.
+ */
+void
+FrameReadback::run()
+{
+    while (!threadShouldExit()) {
+        Slot &slot = slots[nextDeliver];
+
+        if (slot.state.load() != SLOT_MAPPED) {
+            slotMapped.wait(50);
+            continue;
+        }
+
+        if (onFrame) {
+            onFrame(slot.frame);
+        }
+
+        slot.state = SLOT_CONSUMED;
+        nextDeliver = (nextDeliver + 1) % numSlots;
+        slotConsumed.signal();
+    }
+}
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    FrameReadback.h
+    Created: 17 Oct 2026 12:14:51am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "glext.h"
+
+/*
+ * FrameReadback
+ *    Reads rendered frames back to the CPU without stalling the render
+ *    thread. Each capture is a glReadPixels into one of a small ring of
+ *    pixel buffer objects, followed by a fence; the buffer is only mapped
+ *    once the fence has passed, typically two frames later, so frame N
+ *    is read back while frame N + 2 renders.
+ *
+ *    Mapped frames are handed to onFrame on a worker thread, in capture
+ *    order, pointing straight into the mapped buffer (no copy). The
+ *    buffer is unmapped and reused once onFrame returns. If the consumer
+ *    falls behind and every buffer is in use, capture either waits or
+ *    drops the frame, as the caller chooses.
+ */
+class FrameReadback : private juce::Thread
+{
+public:
+    struct Frame
+    {
+        const juce::uint8 *pixels = nullptr; // RGBA8, bottom row first, rows packed
+        int width = 0;
+        int height = 0;
+        juce::uint64 number = 0;
+    };
+
+    FrameReadback(juce::OpenGLContext &glContext);
+    ~FrameReadback() override;
+
+    /*
+     * Worker thread. pixels are only valid until onFrame returns, and are
+     * null for an empty capture or one that couldn't be mapped.
+     */
+    std::function<void(const Frame &frame)> onFrame;
+
+    /*
+     * GL thread. initialise needs a current context and returns false if
+     * the driver has no pixel buffer objects, sync objects or buffer
+     * mapping. release drops frames that haven't been delivered; flush
+     * first to keep them.
+     */
+    bool initialise(int numBuffers = DEFAULT_BUFFERS);
+    void release();
+    bool isAvailable() const
+      { return available; }
+
+    /*
+     * Starts reading back the lower-left width x height of framebuffer.
+     * Returns false if the frame was dropped because every buffer was
+     * still in use and blocking isn't set.
+     */
+    bool capture(GLuint framebuffer, int width, int height,
+                 juce::uint64 frameNumber, bool blocking);
+
+    /*
+     * Maps every capture whose fence has passed and recycles buffers the
+     * consumer is done with. Never blocks; call once per frame.
+     */
+    void poll();
+
+    /*
+     * Blocks until every captured frame has been through onFrame.
+     */
+    void flush();
+
+    int getNumDropped() const { return numDropped.load(); }
+
+    static constexpr int MIN_BUFFERS = 3;
+    static constexpr int MAX_BUFFERS = 4;
+    static constexpr int DEFAULT_BUFFERS = 3;
+
+private:
+    enum SlotState {
+        SLOT_FREE,
+        SLOT_PENDING,  // Readback issued, fence not yet seen
+        SLOT_MAPPED,   // Waiting for / in onFrame
+        SLOT_CONSUMED  // onFrame returned, waiting to be unmapped
+    };
+
+    struct Slot {
+        GLuint buffer = 0;
+        GLsizeiptr capacity = 0;
+        GLsync fence = nullptr;
+        bool mapped = false;
+        Frame frame;
+        std::atomic<int> state { SLOT_FREE };
+    };
+
+    void run() override;
+    void mapSlot(Slot &slot, bool wait);
+    void unmapSlot(Slot &slot);
+    bool waitForSlot(Slot &slot, bool blocking);
+
+    juce::OpenGLContext &glContext;
+    Slot slots[MAX_BUFFERS];
+    int numSlots = 0;
+    int nextCapture = 0; // GL thread
+    int nextMap = 0;     // GL thread, oldest pending capture
+    int nextDeliver = 0; // Worker thread
+    juce::WaitableEvent slotMapped;
+    juce::WaitableEvent slotConsumed;
+    std::atomic<int> numDropped { 0 };
+    bool available = false;
+
+    /*
+     * A fence that takes this long is given up on (lost context, hung
+     * GPU) and its frame mapped anyway.
+     */
+    static constexpr GLuint64 FENCE_TIMEOUT_NS = 1000000000;
+
+    PFNGLFENCESYNCPROC glFenceSync = nullptr;
+    PFNGLDELETESYNCPROC glDeleteSync = nullptr;
+    PFNGLCLIENTWAITSYNCPROC glClientWaitSync = nullptr;
+    PFNGLMAPBUFFERRANGEPROC glMapBufferRange = nullptr;
+    PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameReadback)
+};
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    FrameScheduler.cpp
+    Created: 16 Oct 2026 10:05:33pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(juce::OpenGLContext &glContext) // IN / OUT
+ : juce::Thread("Frame Scheduler"),
+   glContext(glContext)
+{
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    stopThread(1000);
+}
+
+void
+FrameScheduler::setFrameRateLimit(int fps) // IN
+{
+    fps = juce::jmax(0, fps);
+    if (fps == frameRateLimit.load()) {
+        return;
+    }
+
+    frameRateLimit = fps;
+
+    if (fps > 0) {
+        glContext.setContinuousRepainting(false);
+        if (!isThreadRunning()) {
+            startThread(9); // Just below the audio thread
+        }
+        notify(); // Pick up the new period now
+    } else {
+        stopThread(1000);
+        glContext.setContinuousRepainting(true);
+    }
+}
+
+/*
+ * FrameScheduler::run
+ *    Deadlines advance by exactly one period so the average rate is
+ *    right even though each wait is only millisecond-accurate; the last
+ *    millisecond is spent yielding. If the thread falls more than a
+ *    period behind it resynchronises instead of bursting to catch up.
+ */
+void
+FrameScheduler::run()
+{
+    double deadline = juce::Time::getMillisecondCounterHiRes();
+
+    while (!threadShouldExit()) {
+        int fps = frameRateLimit.load();
+        if (fps <= 0) {
+            wait(-1);
+            deadline = juce::Time::getMillisecondCounterHiRes();
+            continue;
+        }
+
+        double period = 1000.0 / fps;
+        double now = juce::Time::getMillisecondCounterHiRes();
+
+        deadline += period;
+        if (deadline < now - period) {
+            deadline = now;
+        }
+
+        bool rateChanged = false;
+        while (deadline - now > 1.0 && !threadShouldExit()) {
+            if (wait((int)(deadline - now - 1.0))) {
+                rateChanged = true;
+                break;
+            }
+            now = juce::Time::getMillisecondCounterHiRes();
+        }
+
+        if (rateChanged) {
+            // Start a fresh period at the new rate
+            deadline = juce::Time::getMillisecondCounterHiRes();
+            continue;
+        }
+
+        while (juce::Time::getMillisecondCounterHiRes() < deadline && !threadShouldExit()) {
+            juce::Thread::yield();
+        }
+
+        glContext.triggerRepaint();
+    }
+}
+
+bool
+FrameScheduler::initialise()
+{
+    glFenceSync = (PFNGLFENCESYNCPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glFenceSync");
+    glDeleteSync = (PFNGLDELETESYNCPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glDeleteSync");
+    glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glClientWaitSync");
+
+    available = glFenceSync != nullptr && glDeleteSync != nullptr &&
+                glClientWaitSync != nullptr;
+
+    firstFence = 0;
+    numFences = 0;
+    lastWaitTime = 0.0;
+
+    return available;
+}
+
+void
+FrameScheduler::release()
+{
+    for (int i = 0; i < numFences; i++) {
+        glDeleteSync(fences[(firstFence + i) % MAX_FENCES]);
+    }
+
+    firstFence = 0;
+    numFences = 0;
+    available = false;
+}
+
+/*
+ * FrameScheduler::waitForFrameSlot
+ *    Retires fences the GPU has already passed, then blocks on the oldest
+ *    until fewer than maxFramesInFlight frames are outstanding. The flush
+ *    bit makes sure the fence has actually been submitted before we wait
+ *    on it.
+ */
+void
+FrameScheduler::waitForFrameSlot(int maxFramesInFlight) // IN
+{
+    lastWaitTime = 0.0;
+
+    if (!available) {
+        return;
+    }
+
+    maxFramesInFlight = juce::jlimit(1, MAX_FENCES, maxFramesInFlight);
+    juce::int64 waitStart = juce::Time::getHighResolutionTicks();
+
+    while (numFences > 0) {
+        GLsync fence = fences[firstFence];
+        bool mustWait = numFences >= maxFramesInFlight;
+
+        GLenum result = glClientWaitSync(fence, mustWait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                         mustWait ? FENCE_TIMEOUT_NS : 0);
+        if (result == GL_TIMEOUT_EXPIRED && !mustWait) {
+            break;
+        }
+
+        glDeleteSync(fence);
+        firstFence = (firstFence + 1) % MAX_FENCES;
+        numFences--;
+    }
+
+    lastWaitTime = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - waitStart);
+}
+
+void
+FrameScheduler::endFrame()
+{
+    if (!available) {
+        return;
+    }
+
+    // waitForFrameSlot always leaves room for one more
+    jassert(numFences < MAX_FENCES);
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence != nullptr) {
+        fences[(firstFence + numFences) % MAX_FENCES] = fence;
+        numFences++;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    FrameScheduler.h
+    Created: 16 Oct 2026 10:05:33pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "glext.h"
+
+/*
+ * FrameScheduler
+ *    Paces the render loop. With a frame rate limit, continuous
+ *    repainting is turned off and a background thread triggers a repaint
+ *    at each deadline; without one, JUCE repaints continuously as before.
+ *
+ *    Independently of the rate, a fence is inserted after each frame and
+ *    the render thread waits for the oldest one before starting a frame
+ *    that would exceed the frames-in-flight limit. This bounds how far
+ *    the CPU (and therefore the audio data in a frame) can run ahead of
+ *    what is on screen.
+ */
+class FrameScheduler : private juce::Thread
+{
+public:
+    FrameScheduler(juce::OpenGLContext &glContext);
+    ~FrameScheduler() override;
+
+    /*
+     * Message thread. 0 disables the limit.
+     */
+    void setFrameRateLimit(int fps);
+    int getFrameRateLimit() const
+      { return frameRateLimit.load(); }
+
+    /*
+     * GL thread. initialise needs a current context and returns false
+     * (and limits nothing) if the driver has no sync objects.
+     */
+    bool initialise();
+    void release();
+    void waitForFrameSlot(int maxFramesInFlight);
+    void endFrame();
+
+    /*
+     * Time the render thread spent blocked in the last waitForFrameSlot,
+     * in seconds.
+     */
+    double getLastWaitTime() const
+      { return lastWaitTime; }
+
+    static constexpr int MAX_FENCES = 4;
+
+private:
+    void run() override;
+
+    juce::OpenGLContext &glContext;
+    std::atomic<int> frameRateLimit { 0 };
+
+    GLsync fences[MAX_FENCES] = { }; // Oldest at firstFence
+    int firstFence = 0;
+    int numFences = 0;
+    double lastWaitTime = 0.0;
+    bool available = false;
+
+    /*
+     * A fence that takes this long is abandoned rather than waited on
+     * forever (lost context, hung GPU).
+     */
+    static constexpr GLuint64 FENCE_TIMEOUT_NS = 100000000;
+
+    PFNGLFENCESYNCPROC glFenceSync = nullptr;
+    PFNGLDELETESYNCPROC glDeleteSync = nullptr;
+    PFNGLCLIENTWAITSYNCPROC glClientWaitSync = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameScheduler)
+};
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    FrameWriter.cpp
+    Created: 16 Oct 2026 11:41:18pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "FrameWriter.h"
+
+FrameWriter::FrameWriter()
+{
+}
+
+FrameWriter::~FrameWriter()
+{
+    juce::String error;
+    close(error);
+}
+
+bool
+FrameWriter::open(const juce::File &dest, // IN
+                  int fmt,                // IN
+                  int w,                  // IN
+                  int h,                  // IN
+                  double fps,             // IN
+                  juce::String &error)    // OUT
+{
+    close(error);
+    error.clear();
+
+    destination = dest;
+    format = fmt;
+    width = w;
+    height = h;
+    numFramesWritten = 0;
+
+    if (format == FORMAT_DISCARD) {
+        return true;
+    }
+
+    if (format == FORMAT_PNG_SEQUENCE) {
+        juce::Result result = destination.createDirectory();
+        if (result.failed()) {
+            error = "Could not create " + destination.getFullPathName() + ": " +
+                    result.getErrorMessage();
+            return false;
+        }
+        return true;
+    }
+
+    VideoSink::Format sinkFormat = format == FORMAT_Y4M      ? VideoSink::FORMAT_Y4M
+                                 : format == FORMAT_RAW_I420 ? VideoSink::FORMAT_I420
+                                 : format == FORMAT_RAW_NV12 ? VideoSink::FORMAT_NV12
+                                                             : VideoSink::FORMAT_RGBA;
+
+    return sink.open(destination, sinkFormat, width, height, fps,
+                     VideoSink::DEFAULT_QUEUE_CAPACITY, error);
+}
+
+bool
+FrameWriter::writeFrame(const juce::uint8 *pixels, // IN
+                        juce::String &error)       // OUT
+{
+    bool written = format == FORMAT_DISCARD      ? true
+                 : format == FORMAT_PNG_SEQUENCE ? writePng(pixels, error)
+                                                 : sink.pushFrame(pixels, error);
+    if (written) {
+        numFramesWritten++;
+    }
+
+    return written;
+}
+
+bool
+FrameWriter::writePng(const juce::uint8 *pixels, // IN
+                      juce::String &error)       // OUT
+{
+    juce::Image image(juce::Image::RGB, width, height, false);
+    {
+        juce::Image::BitmapData bitmap(image, juce::Image::BitmapData::writeOnly);
+        for (int y = 0; y < height; y++) {
+            const juce::uint8 *src = pixels + (size_t)(height - 1 - y) * width * 4;
+            for (int x = 0; x < width; x++, src += 4) {
+                ((juce::PixelRGB *)bitmap.getPixelPointer(x, y))->setARGB(255, src[0], src[1], src[2]);
+            }
+        }
+    }
+
+    juce::File file = destination.getChildFile("frame_" +
+                                               juce::String(numFramesWritten).paddedLeft('0', 6) +
+                                               ".png");
+    file.deleteFile();
+
+    juce::FileOutputStream out(file);
+    if (out.failedToOpen() || !pngFormat.writeImageToStream(image, out)) {
+        error = "Could not write " + file.getFullPathName();
+        return false;
+    }
+
+    return true;
+}
+
+bool
+FrameWriter::close(juce::String &error) // OUT
+{
+    return sink.close(error);
+}
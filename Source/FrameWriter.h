@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    FrameWriter.h
+    Created: 16 Oct 2026 11:41:18pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VideoSink.h"
+
+/*
+ * FrameWriter
+ *    Writes exported frames to disk, either as a numbered PNG sequence
+ *    in a directory (frame_000000.png, ...) or as a video stream to a
+ *    file or named pipe through a VideoSink: YUV4MPEG2, or headerless
+ *    I420, NV12 or top-down RGBA8 frames. Frames are given the way
+ *    glReadPixels returns them, bottom row first.
+ *
+ *    FORMAT_DISCARD writes nothing: frames are still rendered and read
+ *    back, so replaying a capture with it measures rendering alone.
+ */
+class FrameWriter
+{
+public:
+    /*
+     * Enumerators start at 1 so they double as combo box ids.
+     */
+    enum Format {
+        FORMAT_PNG_SEQUENCE = 1,
+        FORMAT_RAW_RGBA,
+        FORMAT_Y4M,
+        FORMAT_RAW_I420,
+        FORMAT_RAW_NV12,
+        FORMAT_DISCARD
+    };
+
+    FrameWriter();
+    ~FrameWriter();
+
+    bool open(const juce::File &destination, int format, int width, int height,
+              double fps, juce::String &error);
+    bool writeFrame(const juce::uint8 *pixels, juce::String &error);
+    bool close(juce::String &error);
+
+    int getNumFramesWritten() const { return numFramesWritten; }
+
+    /*
+     * Queue and back-pressure statistics for video formats. Any thread.
+     */
+    VideoSink::Stats getStreamStats() const
+      { return sink.getStats(); }
+
+    static bool isVideoFormat(int format)
+      { return format != FORMAT_PNG_SEQUENCE && format != FORMAT_DISCARD; }
+
+private:
+    bool writePng(const juce::uint8 *pixels, juce::String &error);
+
+    juce::File destination;
+    int format = FORMAT_PNG_SEQUENCE;
+    int width = 0;
+    int height = 0;
+    int numFramesWritten = 0;
+    VideoSink sink; // Video formats only
+    juce::PNGImageFormat pngFormat;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameWriter)
+};
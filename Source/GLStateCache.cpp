@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    GLStateCache.cpp
+    Created: 16 Oct 2026 2:41:18pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GLStateCache.h"
+
+GLStateCache::GLStateCache(juce::OpenGLExtensionFunctions &extensions) // IN
+    : extensions(extensions)
+{
+}
+
+GLStateCache::~GLStateCache()
+{
+}
+
+void
+GLStateCache::invalidate()
+{
+    programKnown = false;
+    activeUnitKnown = false;
+    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+        textureKnown[i] = false;
+    }
+    framebufferKnown = false;
+    viewportKnown = false;
+}
+
+void
+GLStateCache::resetCounters()
+{
+    numIssued = 0;
+    numFiltered = 0;
+}
+
+bool
+GLStateCache::shouldIssue(bool known, // IN
+                          bool equal) // IN
+{
+    if (known && equal) {
+        numFiltered++;
+        return false;
+    }
+
+    numIssued++;
+    return true;
+}
+
+void
+GLStateCache::useProgram(GLuint newProgram) // IN
+{
+    if (shouldIssue(programKnown, program == newProgram)) {
+        extensions.glUseProgram(newProgram);
+        program = newProgram;
+        programKnown = true;
+    }
+}
+
+/*
+ * GLStateCache::bindTexture
+ *    Binds a 2D texture to the given unit, switching the active unit
+ *    only when the binding actually has to change.
+ */
+void
+GLStateCache::bindTexture(int unit,       // IN
+                          GLuint texture) // IN
+{
+    jassert(unit >= 0 && unit < MAX_TEXTURE_UNITS);
+
+    if (!shouldIssue(textureKnown[unit], textures[unit] == texture)) {
+        return;
+    }
+
+    if (shouldIssue(activeUnitKnown, activeUnit == unit)) {
+        extensions.glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+        activeUnitKnown = true;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    textures[unit] = texture;
+    textureKnown[unit] = true;
+}
+
+void
+GLStateCache::bindFramebuffer(GLuint newFramebuffer) // IN
+{
+    if (shouldIssue(framebufferKnown, framebuffer == newFramebuffer)) {
+        extensions.glBindFramebuffer(GL_FRAMEBUFFER, newFramebuffer);
+        framebuffer = newFramebuffer;
+        framebufferKnown = true;
+    }
+}
+
+void
+GLStateCache::viewport(GLint x,          // IN
+                       GLint y,          // IN
+                       GLsizei width,    // IN
+                       GLsizei height)   // IN
+{
+    bool equal = viewportRect[0] == x && viewportRect[1] == y &&
+                 viewportRect[2] == width && viewportRect[3] == height;
+
+    if (shouldIssue(viewportKnown, equal)) {
+        glViewport(x, y, width, height);
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = width;
+        viewportRect[3] = height;
+        viewportKnown = true;
+    }
+}
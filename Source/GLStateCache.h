@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    GLStateCache.h
+    Created: 16 Oct 2026 2:41:18pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ * GLStateCache
+ *    Shadows the bits of GL state the renderer changes between passes
+ *    (current program, active texture unit, 2D texture bindings, draw
+ *    framebuffer and viewport) and drops calls that would set a value
+ *    that is already current. Anything outside the renderer may touch
+ *    this state, so the cache must be invalidated whenever control
+ *    returns from JUCE, i.e. at the start of every frame.
+ */
+class GLStateCache
+{
+public:
+    GLStateCache(juce::OpenGLExtensionFunctions &extensions);
+    ~GLStateCache();
+
+    /*
+     * Forgets everything; the next call of each kind is always issued.
+     */
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindTexture(int unit, GLuint texture);
+    void bindFramebuffer(GLuint framebuffer);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /*
+     * State change statistics since the last resetCounters().
+     */
+    void resetCounters();
+    int getNumIssued() const { return numIssued; }
+    int getNumFiltered() const { return numFiltered; }
+
+    static constexpr int MAX_TEXTURE_UNITS = 16;
+
+private:
+    bool shouldIssue(bool known, bool equal);
+
+    juce::OpenGLExtensionFunctions &extensions;
+
+    bool programKnown = false;
+    GLuint program = 0;
+
+    bool activeUnitKnown = false;
+    int activeUnit = 0;
+
+    bool textureKnown[MAX_TEXTURE_UNITS] = { };
+    GLuint textures[MAX_TEXTURE_UNITS] = { };
+
+    bool framebufferKnown = false;
+    GLuint framebuffer = 0;
+
+    bool viewportKnown = false;
+    GLint viewportRect[4] = { };
+
+    int numIssued = 0;
+    int numFiltered = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GLStateCache)
+};
@@ -0,0 +1,508 @@
+/*
+  ==============================================================================
+
+    HeadlessContext.cpp
+    Created: 16 Oct 2026 11:02:40pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "HeadlessContext.h"
+
+#if JUCE_LINUX
+
+#include <EGL/eglext.h>
+#include <GL/glx.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static const EGLint contextAttribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+    EGL_NONE
+};
+
+HeadlessContext::HeadlessContext()
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    release();
+}
+
+EGLDisplay
+HeadlessContext::getDisplay()
+{
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if (clientExtensions != nullptr && eglGetPlatformDisplayEXT != nullptr &&
+        juce::String(clientExtensions).contains("EGL_MESA_platform_surfaceless")) {
+        EGLDisplay surfaceless = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                                          EGL_DEFAULT_DISPLAY, nullptr);
+        if (surfaceless != EGL_NO_DISPLAY) {
+            return surfaceless;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool
+HeadlessContext::create(juce::String &error) // OUT
+{
+    static const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+
+    release();
+
+    display = getDisplay();
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        error = "Could not initialise an EGL display";
+        display = EGL_NO_DISPLAY;
+        goto failure;
+    }
+    ownsDisplay = true;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        error = "EGL display has no desktop OpenGL";
+        goto failure;
+    }
+
+    /*
+     * The surfaceless platform has no pbuffer configs, so fall back to
+     * any OpenGL config there.
+     */
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        static const EGLint anyConfigAttribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        if (!eglChooseConfig(display, anyConfigAttribs, &config, 1, &numConfigs) ||
+            numConfigs == 0) {
+            error = "No EGL config supports OpenGL";
+            goto failure;
+        }
+    }
+
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        error = "Could not create an OpenGL 3.3 compatibility context";
+        goto failure;
+    }
+
+    if (!createSurface(config, error)) {
+        goto failure;
+    }
+
+    if (!makeCurrent()) {
+        error = "Could not make the OpenGL context current";
+        goto failure;
+    }
+
+    glContext.extensions.initialise();
+    return true;
+
+failure:
+    release();
+    return false;
+}
+
+bool
+HeadlessContext::createSurface(EGLConfig config,    // IN
+                               juce::String &error) // OUT
+{
+    static const EGLint pbufferAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+
+    if (juce::String(eglQueryString(display, EGL_EXTENSIONS)).contains("EGL_KHR_surfaceless_context")) {
+        return true;
+    }
+
+    surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        error = "Could not create a pbuffer surface";
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * HeadlessContext::createShared
+ *    The shared context uses the config of the one it shares with, so
+ *    the two are sure to be compatible.
+ */
+bool
+HeadlessContext::createShared(juce::String &error) // OUT
+{
+    EGLContext shareContext = eglGetCurrentContext();
+    EGLConfig config = nullptr;
+    EGLint configId = 0;
+    EGLint numConfigs = 0;
+
+    release();
+
+    if (shareContext == EGL_NO_CONTEXT) {
+        return createSharedGLX(error);
+    }
+
+    display = eglGetCurrentDisplay();
+    ownsDisplay = false;
+
+    eglQueryContext(display, shareContext, EGL_CONFIG_ID, &configId);
+    const EGLint configAttribs[] = {
+        EGL_CONFIG_ID, configId,
+        EGL_NONE
+    };
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        error = "Could not find the EGL config of the current context";
+        goto failure;
+    }
+
+    context = eglCreateContext(display, config, shareContext, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        error = "Could not create an OpenGL context sharing with the current one";
+        goto failure;
+    }
+
+    if (!createSurface(config, error)) {
+        goto failure;
+    }
+
+    return true;
+
+failure:
+    release();
+    return false;
+}
+
+/*
+ * HeadlessContext::createSharedGLX
+ *    Contexts on the same screen can share whatever their configs, so
+ *    any config with pbuffers will do. The X connection is the current
+ *    context's; JUCE initialises Xlib for threads.
+ */
+bool
+HeadlessContext::createSharedGLX(juce::String &error) // OUT
+{
+    static const int configAttribs[] = {
+        GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+        GLX_RENDER_TYPE, GLX_RGBA_BIT,
+        None
+    };
+    static const int pbufferAttribs[] = {
+        GLX_PBUFFER_WIDTH, 1,
+        GLX_PBUFFER_HEIGHT, 1,
+        None
+    };
+
+    Display *x11Display = glXGetCurrentDisplay();
+    GLXContext shareContext = glXGetCurrentContext();
+    GLXFBConfig *configs = nullptr;
+    int numConfigs = 0;
+    int screen = 0;
+
+    if (x11Display == nullptr || shareContext == nullptr) {
+        error = "No OpenGL context is current";
+        return false;
+    }
+
+    glXQueryContext(x11Display, shareContext, GLX_SCREEN, &screen);
+    configs = glXChooseFBConfig(x11Display, screen, configAttribs, &numConfigs);
+    if (configs == nullptr || numConfigs == 0) {
+        error = "No GLX config supports pbuffers";
+        goto failure;
+    }
+
+    glxDisplay = x11Display;
+    glxContext = glXCreateNewContext(x11Display, configs[0], GLX_RGBA_TYPE, shareContext, True);
+    if (glxContext == nullptr) {
+        error = "Could not create an OpenGL context sharing with the current one";
+        goto failure;
+    }
+
+    glxPbuffer = glXCreatePbuffer(x11Display, configs[0], pbufferAttribs);
+    if (glxPbuffer == None) {
+        error = "Could not create a pbuffer";
+        goto failure;
+    }
+
+    XFree(configs);
+    return true;
+
+failure:
+    if (configs != nullptr) {
+        XFree(configs);
+    }
+    release();
+    return false;
+}
+
+bool
+HeadlessContext::makeCurrent()
+{
+    if (glxContext != nullptr) {
+        return glXMakeContextCurrent((Display *)glxDisplay, glxPbuffer, glxPbuffer,
+                                     (GLXContext)glxContext) == True;
+    }
+
+    return context != EGL_NO_CONTEXT &&
+           eglMakeCurrent(display, surface, surface, context) == EGL_TRUE;
+}
+
+void
+HeadlessContext::doneCurrent()
+{
+    if (glxContext != nullptr) {
+        if (glXGetCurrentContext() == (GLXContext)glxContext) {
+            glXMakeContextCurrent((Display *)glxDisplay, None, None, nullptr);
+        }
+        return;
+    }
+
+    // Only ever release our own context, not one current on this thread
+    if (context != EGL_NO_CONTEXT && eglGetCurrentContext() == context) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+}
+
+void
+HeadlessContext::release()
+{
+    doneCurrent();
+
+    if (glxDisplay != nullptr) {
+        Display *x11Display = (Display *)glxDisplay;
+
+        if (glxPbuffer != None) {
+            glXDestroyPbuffer(x11Display, glxPbuffer);
+            glxPbuffer = None;
+        }
+
+        if (glxContext != nullptr) {
+            glXDestroyContext(x11Display, (GLXContext)glxContext);
+            glxContext = nullptr;
+        }
+
+        glxDisplay = nullptr;
+    }
+
+    if (display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+        surface = EGL_NO_SURFACE;
+    }
+
+    if (context != EGL_NO_CONTEXT) {
+        eglDestroyContext(display, context);
+        context = EGL_NO_CONTEXT;
+    }
+
+    if (ownsDisplay) {
+        eglTerminate(display);
+        ownsDisplay = false;
+    }
+    display = EGL_NO_DISPLAY;
+}
+
+#elif JUCE_WINDOWS
+
+#include <windows.h>
+
+HeadlessContext::HeadlessContext()
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    release();
+}
+
+/*
+ * HeadlessContext::createWindow
+ *    WGL can only make a context current on a window's device context,
+ *    so the context gets a window of its own. It is message-only: the
+ *    thread that creates it doesn't pump messages, and a top-level
+ *    window there would hang anyone broadcasting one. The predefined
+ *    STATIC class saves registering one.
+ *
+ *    Windows can only be destroyed by the thread that created them, so
+ *    release has to be called there too.
+ */
+bool
+HeadlessContext::createWindow(juce::String &error) // OUT
+{
+    HWND hwnd = CreateWindowExW(0, L"STATIC", L"", 0, 0, 0, 1, 1,
+                                HWND_MESSAGE, nullptr, GetModuleHandleW(nullptr), nullptr);
+    if (hwnd == nullptr) {
+        error = "Could not create a window for the OpenGL context";
+        return false;
+    }
+
+    window = hwnd;
+    dc = GetDC(hwnd);
+    if (dc == nullptr) {
+        error = "Could not get a device context for the OpenGL context";
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * HeadlessContext::create
+ *    A legacy context, which drivers give the highest compatibility
+ *    profile they support, the same as JUCE's.
+ */
+bool
+HeadlessContext::create(juce::String &error) // OUT
+{
+    PIXELFORMATDESCRIPTOR pfd = { };
+    int pixelFormat;
+
+    release();
+
+    if (!createWindow(error)) {
+        goto failure;
+    }
+
+    pfd.nSize = sizeof(pfd);
+    pfd.nVersion = 1;
+    pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+    pfd.iPixelType = PFD_TYPE_RGBA;
+    pfd.cColorBits = 24;
+    pfd.cAlphaBits = 8;
+    pfd.iLayerType = PFD_MAIN_PLANE;
+
+    pixelFormat = ChoosePixelFormat((HDC)dc, &pfd);
+    if (pixelFormat == 0 || !SetPixelFormat((HDC)dc, pixelFormat, &pfd)) {
+        error = "No pixel format supports OpenGL";
+        goto failure;
+    }
+
+    context = wglCreateContext((HDC)dc);
+    if (context == nullptr) {
+        error = "Could not create an OpenGL context";
+        goto failure;
+    }
+
+    if (!makeCurrent()) {
+        error = "Could not make the OpenGL context current";
+        goto failure;
+    }
+
+    glContext.extensions.initialise();
+    return true;
+
+failure:
+    release();
+    return false;
+}
+
+/*
+ * HeadlessContext::createShared
+ *    The window gets the pixel format of the current context's, so the
+ *    two contexts are sure to be compatible.
+ */
+bool
+HeadlessContext::createShared(juce::String &error) // OUT
+{
+    HGLRC shareContext = wglGetCurrentContext();
+    HDC shareDC = wglGetCurrentDC();
+    PIXELFORMATDESCRIPTOR pfd = { };
+    int pixelFormat;
+
+    release();
+
+    if (shareContext == nullptr || shareDC == nullptr) {
+        error = "No OpenGL context is current";
+        goto failure;
+    }
+
+    if (!createWindow(error)) {
+        goto failure;
+    }
+
+    pixelFormat = GetPixelFormat(shareDC);
+    if (pixelFormat == 0 ||
+        DescribePixelFormat(shareDC, pixelFormat, sizeof(pfd), &pfd) == 0 ||
+        !SetPixelFormat((HDC)dc, pixelFormat, &pfd)) {
+        error = "Could not use the pixel format of the current context";
+        goto failure;
+    }
+
+    // Sharing has to be set up before the new context has any objects
+    context = wglCreateContext((HDC)dc);
+    if (context == nullptr || !wglShareLists(shareContext, (HGLRC)context)) {
+        error = "Could not create an OpenGL context sharing with the current one";
+        goto failure;
+    }
+
+    return true;
+
+failure:
+    release();
+    return false;
+}
+
+bool
+HeadlessContext::makeCurrent()
+{
+    return context != nullptr && wglMakeCurrent((HDC)dc, (HGLRC)context) != FALSE;
+}
+
+void
+HeadlessContext::doneCurrent()
+{
+    // Only ever release our own context, not one current on this thread
+    if (context != nullptr && wglGetCurrentContext() == (HGLRC)context) {
+        wglMakeCurrent(nullptr, nullptr);
+    }
+}
+
+void
+HeadlessContext::release()
+{
+    doneCurrent();
+
+    if (context != nullptr) {
+        wglDeleteContext((HGLRC)context);
+        context = nullptr;
+    }
+
+    if (dc != nullptr) {
+        ReleaseDC((HWND)window, (HDC)dc);
+        dc = nullptr;
+    }
+
+    if (window != nullptr) {
+        DestroyWindow((HWND)window);
+        window = nullptr;
+    }
+}
+
+#endif // JUCE_LINUX / JUCE_WINDOWS
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    HeadlessContext.h
+    Created: 16 Oct 2026 11:02:40pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_LINUX || JUCE_WINDOWS
+
+#if JUCE_LINUX
+#include <EGL/egl.h>
+#endif
+
+/*
+ * HeadlessContext
+ *    An OpenGL context with no window, for running a RenderEngine from
+ *    tests and tools, or for GL work on a thread of its own. On Linux it
+ *    uses EGL on the surfaceless platform when Mesa offers it (so it
+ *    works without a display or GPU, e.g. llvmpipe), otherwise the
+ *    default display with a 1x1 pbuffer. On Windows it is a WGL context
+ *    on a message-only window.
+ *
+ *    Like the editor's JUCE context, it asks for a 3.3 compatibility
+ *    profile where it can choose, so passes can draw without a vertex
+ *    array object.
+ *
+ *    getContext() returns an unattached juce::OpenGLContext whose
+ *    extension table is loaded once this context is current, which is
+ *    what RenderEngine and the other GL helpers take. JUCE looks GL
+ *    functions up with glXGetProcAddress; under libglvnd those entry
+ *    points dispatch to whichever context is current, EGL included.
+ *
+ *    createShared makes a context in the share group of the one current
+ *    on the calling thread, for another thread to use (ShaderCompiler
+ *    builds programs in one). On Linux that is an EGL context when the
+ *    current one is EGL, and a GLX context with a pbuffer otherwise,
+ *    since EGL and GLX contexts can't share.
+ */
+class HeadlessContext
+{
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    /*
+     * Creates the context and makes it current on the calling thread.
+     * Returns false with a reason in error on failure.
+     */
+    bool create(juce::String &error);
+
+    /*
+     * Creates a context sharing objects with the one current on the
+     * calling thread. It is left not current: the thread using it calls
+     * makeCurrent, and doneCurrent before it goes away.
+     */
+    bool createShared(juce::String &error);
+
+    void release();
+    bool makeCurrent();
+    void doneCurrent();
+
+    juce::OpenGLContext &getContext() { return glContext; }
+
+private:
+#if JUCE_LINUX
+    EGLDisplay getDisplay();
+    bool createSurface(EGLConfig config, juce::String &error);
+    bool createSharedGLX(juce::String &error);
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    bool ownsDisplay = false; // Shared contexts borrow the current display
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE; // Stays EGL_NO_SURFACE when surfaceless
+
+    /*
+     * Used instead of the EGL handles when sharing with a GLX context.
+     * Kept opaque so this header doesn't need GLX.
+     */
+    void *glxDisplay = nullptr;
+    void *glxContext = nullptr;
+    unsigned long glxPbuffer = 0;
+#else
+    bool createWindow(juce::String &error);
+
+    /*
+     * HWND, HDC and HGLRC, kept opaque so this header doesn't need
+     * windows.h.
+     */
+    void *window = nullptr;
+    void *dc = nullptr;
+    void *context = nullptr;
+#endif
+
+    juce::OpenGLContext glContext;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HeadlessContext)
+};
+
+#endif // JUCE_LINUX || JUCE_WINDOWS
@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    InputRecorder.cpp
+    Created: 17 Oct 2026 2:16:30am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "InputRecorder.h"
+#include "CaptureReader.h"
+
+InputRecorder::InputRecorder(ShadertoyAudioProcessor &processor) // IN / OUT
+ : juce::Thread("Input Recorder"),
+   processor(processor)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+    juce::String error;
+    stop(error);
+}
+
+bool
+InputRecorder::start(const juce::File &captureFile, // IN
+                     juce::String &error)           // OUT
+{
+    if (recording.load()) {
+        error = "Already recording";
+        return false;
+    }
+
+    file = captureFile;
+    file.deleteFile();
+    output.reset(new juce::FileOutputStream(file));
+    if (output->failedToOpen()) {
+        error = "Could not open " + file.getFullPathName() + ": " +
+                output->getStatus().getErrorMessage();
+        output.reset();
+        return false;
+    }
+
+    const int numParameters = processor.getParameters().size();
+    output->writeInt((int)CaptureReader::MAGIC);
+    output->writeInt((int)CaptureReader::VERSION);
+    output->writeInt(numParameters);
+
+    record.malloc(MAX_RECORD_BYTES);
+    ring.malloc(RING_BYTES);
+    ringFifo.reset();
+
+    parameterValues.assign((size_t)numParameters, 0.0f);
+    changedParameters.resize((size_t)numParameters);
+    firstBlock = true;
+    pendingGap = 0;
+    firstTimestamp = -1.0;
+
+    {
+        const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+        lastError.clear();
+    }
+    writeFailed = false;
+    numBlocksRecorded = 0;
+    numBlocksDropped = 0;
+    numBytesWritten = 12;
+    secondsRecorded = 0.0;
+
+    startThread();
+    recording = true;
+    processor.addAudioListener(this);
+    return true;
+}
+
+bool
+InputRecorder::stop(juce::String &error) // OUT
+{
+    if (!recording.exchange(false)) {
+        return true;
+    }
+
+    // No block can be on its way into the ring after this
+    processor.removeAudioListener(this);
+
+    stopThread(10000);
+
+    output->flush();
+    output.reset();
+
+    const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+    if (writeFailed.load()) {
+        error = lastError;
+        lastError.clear();
+        return false;
+    }
+
+    return true;
+}
+
+juce::String
+InputRecorder::getLastError() const
+{
+    const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+    return lastError;
+}
+
+/*
+ * InputRecorder::handleAudioFrame
+ *    Called on the audio thread. The records for a block (a gap marker
+ *    if blocks were dropped before it, the parameters that changed and
+ *    the block itself) go into the ring together or not at all, so the
+ *    file never holds half a block.
+ */
+void
+InputRecorder::handleAudioFrame(double timestamp,                 // IN
+                                double sampleRate,                // IN
+                                juce::AudioBuffer<float>& buffer, // IN
+                                juce::MidiBuffer &midiBuffer)     // IN
+{
+    if (!recording.load()) {
+        return;
+    }
+
+    const juce::Array<juce::AudioProcessorParameter *> &parameters = processor.getParameters();
+    const int numParameters = juce::jmin(parameters.size(), (int)parameterValues.size());
+    int numChanged = 0;
+
+    for (int i = 0; i < numParameters; i++) {
+        float value = parameters.getUnchecked(i)->getValue();
+        if (firstBlock || value != parameterValues[(size_t)i]) {
+            changedParameters[(size_t)numChanged++] = { i, value };
+        }
+    }
+
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+
+    size_t size = 5 + 28 + (size_t)numChannels * numSamples * sizeof(float);
+    for (const auto metadata : midiBuffer) {
+        size += 8 + (size_t)metadata.numBytes;
+    }
+    if (numChanged > 0) {
+        size += 5 + 4 + (size_t)numChanged * 8;
+    }
+    if (pendingGap > 0) {
+        size += 5 + 4;
+    }
+
+    if (size > (size_t)MAX_RECORD_BYTES || (int)size > ringFifo.getFreeSpace()) {
+        numBlocksDropped++;
+        pendingGap++;
+        return;
+    }
+
+    juce::MemoryOutputStream out(record.get(), MAX_RECORD_BYTES);
+
+    if (pendingGap > 0) {
+        out.writeByte((char)CaptureReader::RECORD_GAP);
+        out.writeInt(4);
+        out.writeInt(pendingGap);
+    }
+
+    if (numChanged > 0) {
+        out.writeByte((char)CaptureReader::RECORD_PARAMETERS);
+        out.writeInt(4 + numChanged * 8);
+        out.writeInt(numChanged);
+
+        for (int i = 0; i < numChanged; i++) {
+            out.writeInt(changedParameters[(size_t)i].first);
+            out.writeFloat(changedParameters[(size_t)i].second);
+        }
+    }
+
+    const juce::int64 blockStart = (juce::int64)out.getPosition() + 5;
+    out.writeByte((char)CaptureReader::RECORD_BLOCK);
+    out.writeInt(0); // Payload size, filled in below
+    out.writeDouble(timestamp);
+    out.writeDouble(sampleRate);
+    out.writeInt(numChannels);
+    out.writeInt(numSamples);
+    out.writeInt(midiBuffer.getNumEvents());
+
+    for (int ch = 0; ch < numChannels; ch++) {
+        const float *samples = buffer.getReadPointer(ch);
+#if JUCE_BIG_ENDIAN
+        for (int i = 0; i < numSamples; i++) {
+            out.writeFloat(samples[i]);
+        }
+#else
+        out.write(samples, (size_t)numSamples * sizeof(float));
+#endif
+    }
+
+    for (const auto metadata : midiBuffer) {
+        out.writeInt(metadata.samplePosition);
+        out.writeInt(metadata.numBytes);
+        out.write(metadata.data, (size_t)metadata.numBytes);
+    }
+
+    juce::uint32 payloadSize = juce::ByteOrder::swapIfBigEndian(
+        (juce::uint32)((juce::int64)out.getPosition() - blockStart));
+    memcpy(record.get() + blockStart - 4, &payloadSize, sizeof(payloadSize));
+
+    jassert(out.getPosition() == (juce::int64)size);
+    pushToRing(record.get(), (int)out.getPosition());
+
+    for (int i = 0; i < numChanged; i++) {
+        parameterValues[(size_t)changedParameters[(size_t)i].first] =
+            changedParameters[(size_t)i].second;
+    }
+
+    firstBlock = false;
+    pendingGap = 0;
+    numBlocksRecorded++;
+
+    if (firstTimestamp < 0.0) {
+        firstTimestamp = timestamp;
+    }
+    secondsRecorded = timestamp + numSamples / sampleRate - firstTimestamp;
+}
+
+void
+InputRecorder::pushToRing(const void *data, // IN
+                          int numBytes)     // IN
+{
+    int start1, size1, start2, size2;
+    ringFifo.prepareToWrite(numBytes, start1, size1, start2, size2);
+    jassert(size1 + size2 == numBytes);
+
+    memcpy(ring.get() + start1, data, (size_t)size1);
+    memcpy(ring.get() + start2, (const char *)data + size1, (size_t)size2);
+    ringFifo.finishedWrite(size1 + size2);
+}
+
+/*
+ * InputRecorder::drainRing
+ *    After a failed write the ring is still emptied, so the audio
+ *    thread keeps going rather than dropping every block.
+ */
+void
+InputRecorder::drainRing()
+{
+    int start1, size1, start2, size2;
+    ringFifo.prepareToRead(ringFifo.getNumReady(), start1, size1, start2, size2);
+
+    if (!writeFailed.load()) {
+        bool written = output->write(ring.get() + start1, (size_t)size1) &&
+                       output->write(ring.get() + start2, (size_t)size2);
+        if (written) {
+            numBytesWritten += size1 + size2;
+        } else {
+            const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+            lastError = "Could not write " + file.getFullPathName();
+            writeFailed = true;
+        }
+    }
+
+    ringFifo.finishedRead(size1 + size2);
+}
+
+/*
+ * InputRecorder::run
+ *    Waking the writer would mean taking a lock on the audio thread, so
+ *    it polls the ring instead. stopThread wakes it for the final drain.
+ */
+void
+InputRecorder::run()
+{
+    while (!threadShouldExit()) {
+        wait(WRITE_INTERVAL_MS);
+        drainRing();
+    }
+
+    // Whatever the audio thread queued before it was unregistered
+    drainRing();
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    InputRecorder.h
+    Created: 17 Oct 2026 2:16:30am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+/*
+ * InputRecorder
+ *    Captures everything the visualization reacts to, as the processor
+ *    receives it: each audio block with its timestamp and midi, and any
+ *    parameter that changed since the block before. Replaying the file
+ *    (OfflineExporter::renderCapture) renders the same frames however
+ *    the DAW was timing things, so patches can be benchmarked and
+ *    diffed frame for frame. The format is described in CaptureReader.
+ *
+ *    Records are built on the audio thread into a preallocated ring and
+ *    written to disk by a worker thread. Nothing there blocks or
+ *    allocates: a block that doesn't fit is dropped, counted, and marked
+ *    in the file with a gap record.
+ */
+class InputRecorder : public ShadertoyAudioProcessor::AudioListener,
+                      private juce::Thread
+{
+public:
+    InputRecorder(ShadertoyAudioProcessor &processor);
+    ~InputRecorder() override;
+
+    /*
+     * Message thread. stop returns false if writing the capture failed,
+     * with the reason in error, and clears it for the next capture.
+     */
+    bool start(const juce::File &file, juce::String &error);
+    bool stop(juce::String &error);
+    bool isRecording() const { return recording.load(); }
+
+    int getNumBlocksRecorded() const { return numBlocksRecorded.load(); }
+    int getNumBlocksDropped() const { return numBlocksDropped.load(); }
+    juce::int64 getNumBytesWritten() const { return numBytesWritten.load(); }
+    double getSecondsRecorded() const { return secondsRecorded.load(); }
+    juce::String getLastError() const;
+
+    void handleAudioFrame(double timestamp, double sampleRate,
+                          juce::AudioBuffer<float>& buffer,
+                          juce::MidiBuffer &midiBuffer) override;
+
+private:
+    void run() override;
+    void pushToRing(const void *data, int numBytes);
+    void drainRing();
+
+    /*
+     * Ring between the audio thread and the writer. 8 MB holds several
+     * seconds of stereo audio, should the disk stall.
+     */
+    static constexpr int RING_BYTES = 8 << 20;
+
+    /*
+     * Largest single record; bigger blocks are dropped.
+     */
+    static constexpr int MAX_RECORD_BYTES = 1 << 20;
+
+    static constexpr int WRITE_INTERVAL_MS = 50;
+
+    ShadertoyAudioProcessor &processor;
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> output;
+
+    /*
+     * Audio thread only: the records being built, the parameter values
+     * last written and the (index, value) pairs that changed since.
+     */
+    juce::HeapBlock<char> record;
+    std::vector<float> parameterValues;
+    std::vector<std::pair<int, float>> changedParameters;
+    bool firstBlock = true;
+    int pendingGap = 0;
+
+    juce::HeapBlock<char> ring;
+    juce::AbstractFifo ringFifo { RING_BYTES };
+
+    std::atomic<bool> recording { false };
+    std::atomic<bool> writeFailed { false };
+    std::atomic<int> numBlocksRecorded { 0 };
+    std::atomic<int> numBlocksDropped { 0 };
+    std::atomic<juce::int64> numBytesWritten { 0 };
+    std::atomic<double> secondsRecorded { 0.0 };
+    double firstTimestamp = -1.0; // Audio thread only
+    mutable juce::SpinLock errorLock;
+    juce::String lastError;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InputRecorder)
+};
@@ -0,0 +1,592 @@
+/*
+  ==============================================================================
+
+    OfflineExporter.cpp
+    Created: 16 Oct 2026 11:29:05pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineExporter.h"
+#include "HeadlessContext.h"
+#include "CaptureReader.h"
+
+OfflineExporter::OfflineExporter(ShadertoyAudioProcessor &processor) // IN / OUT
+ : juce::Thread("Offline Export"),
+   processor(processor)
+{
+}
+
+OfflineExporter::~OfflineExporter()
+{
+    stop();
+}
+
+bool
+OfflineExporter::armHostBounce(const Settings &newSettings, // IN
+                               juce::String &error)         // OUT
+{
+    if (!start(newSettings, SOURCE_HOST_BOUNCE, juce::File(), error)) {
+        return false;
+    }
+
+    processor.addAudioListener(this);
+    listening = true;
+    return true;
+}
+
+bool
+OfflineExporter::renderFile(const Settings &newSettings, // IN
+                            const juce::File &file,      // IN
+                            juce::String &error)         // OUT
+{
+    if (!file.existsAsFile()) {
+        error = file.getFullPathName() + " does not exist";
+        return false;
+    }
+
+    return start(newSettings, SOURCE_AUDIO_FILE, file, error);
+}
+
+bool
+OfflineExporter::renderCapture(const Settings &newSettings, // IN
+                               const juce::File &file,      // IN
+                               juce::String &error)         // OUT
+{
+    if (!file.existsAsFile()) {
+        error = file.getFullPathName() + " does not exist";
+        return false;
+    }
+
+    return start(newSettings, SOURCE_CAPTURE, file, error);
+}
+
+/*
+ * OfflineExporter::start
+ *    Sets up a take and starts the render thread. The engine is built
+ *    here since it registers with the processor, which is only safe on
+ *    the message thread; everything that needs the context happens on
+ *    the render thread.
+ */
+bool
+OfflineExporter::start(const Settings &newSettings, // IN
+                       Source newSource,            // IN
+                       const juce::File &file,      // IN
+                       juce::String &error)         // OUT
+{
+    State current = state.load();
+    if (isThreadRunning() || current == STATE_ARMED || current == STATE_RENDERING) {
+        error = "An export is already running";
+        return false;
+    }
+
+#if JUCE_LINUX || JUCE_WINDOWS
+    source = newSource;
+    inputFile = file;
+    settings = newSettings;
+    settings.fps = juce::jlimit(MIN_FPS, MAX_FPS, settings.fps);
+    settings.width = juce::jmax(1, settings.width);
+    settings.height = juce::jmax(1, settings.height);
+    settings.realTime = settings.realTime && source != SOURCE_HOST_BOUNCE;
+
+    context.reset(new HeadlessContext());
+    engine.reset(new RenderEngine(processor, context->getContext()));
+    readback.reset(new FrameReadback(context->getContext()));
+    readback->onFrame = [this](const FrameReadback::Frame &frame) {
+        writeFrame(frame);
+    };
+    engine->onError = [this](const juce::String &title, const juce::String &message) {
+        const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+        lastError = title + ": " + message;
+    };
+
+    {
+        const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+        lastError.clear();
+    }
+    numFramesWritten = 0;
+    secondsRendered = 0.0;
+    totalSeconds = 0.0;
+    wallSeconds = 0.0;
+    hostRealtimeAgain = false;
+    writeFailed = false;
+    blockReady.reset();
+    blockDone.reset();
+
+    state = STATE_ARMED;
+    startThread();
+    return true;
+#else
+    (void)(newSettings);
+    (void)(newSource);
+    (void)(file);
+    error = "Offline export needs a headless OpenGL context, which is only "
+            "available on Linux and Windows for now";
+    return false;
+#endif
+}
+
+void
+OfflineExporter::stop()
+{
+    if (listening.exchange(false)) {
+        // Waits out a block the audio thread is handing us, if any
+        processor.removeAudioListener(this);
+    }
+
+    signalThreadShouldExit();
+    blockReady.signal();
+    stopThread(10000);
+    cancelPendingUpdate();
+
+    readback.reset();
+    engine.reset();
+#if JUCE_LINUX || JUCE_WINDOWS
+    context.reset();
+#endif
+
+    if (state.load() == STATE_ARMED) {
+        state = STATE_IDLE;
+    }
+}
+
+/*
+ * OfflineExporter::handleAsyncUpdate
+ *    Cleans up on the message thread once the render thread is done.
+ */
+void
+OfflineExporter::handleAsyncUpdate()
+{
+    stop();
+}
+
+juce::String
+OfflineExporter::getLastError() const
+{
+    const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+    return lastError;
+}
+
+void
+OfflineExporter::setFailed(const juce::String &error) // IN
+{
+    {
+        const juce::SpinLock::ScopedLockType scopedLock(errorLock);
+        lastError = error;
+    }
+    state = STATE_FAILED;
+}
+
+/*
+ * OfflineExporter::handleAudioFrame
+ *    Called on the audio thread. Blocks of a bounce are passed to the
+ *    render thread as they are, without copying, and this waits until
+ *    the frames they complete have been written.
+ */
+void
+OfflineExporter::handleAudioFrame(double timestamp,                 // IN
+                                  double sampleRate,                // IN
+                                  juce::AudioBuffer<float>& buffer, // IN
+                                  juce::MidiBuffer &midiBuffer)     // IN
+{
+    State current = state.load();
+    if (current != STATE_ARMED && current != STATE_RENDERING) {
+        return;
+    }
+
+    if (!processor.isNonRealtime()) {
+        if (current == STATE_RENDERING) {
+            hostRealtimeAgain = true;
+            blockReady.signal();
+        }
+        return;
+    }
+
+    hostBlock.timestamp = timestamp;
+    hostBlock.sampleRate = sampleRate;
+    hostBlock.buffer = &buffer;
+    hostBlock.midiBuffer = &midiBuffer;
+    blockReady.signal();
+
+    while (!blockDone.wait(100)) {
+        if (!isThreadRunning()) {
+            return;
+        }
+    }
+}
+
+void
+OfflineExporter::run()
+{
+    juce::String error;
+    bool succeeded = beginTake(error);
+    if (succeeded) {
+        switch (source) {
+        case SOURCE_AUDIO_FILE:
+            succeeded = runFile(error);
+            break;
+        case SOURCE_CAPTURE:
+            succeeded = runCapture(error);
+            break;
+        default:
+            succeeded = runHostBounce(error);
+            break;
+        }
+    }
+
+    endTake();
+
+    if (succeeded && writeFailed.load()) {
+        succeeded = false;
+        error = writeError;
+    }
+
+    if (!succeeded) {
+        setFailed(error);
+    } else if (takeStart < 0.0) {
+        state = STATE_IDLE; // Stopped before the host sent anything
+    } else {
+        state = STATE_FINISHED;
+    }
+
+    triggerAsyncUpdate();
+}
+
+bool
+OfflineExporter::beginTake(juce::String &error) // OUT
+{
+#if JUCE_LINUX || JUCE_WINDOWS
+    if (!context->create(error)) {
+        return false;
+    }
+#endif
+
+    if (!engine->initialise(false)) {
+        error = getLastError();
+        return false;
+    }
+
+    /*
+     * Every pass has to be there from the first frame, or the output
+     * would depend on how fast the driver compiles.
+     */
+    engine->finishProgramBuilds();
+
+    if (!readback->initialise()) {
+        error = "Offline export needs pixel buffer objects and sync objects (OpenGL 3.2)";
+        return false;
+    }
+
+    if (!writer.open(settings.destination, settings.format,
+                     settings.width, settings.height, settings.fps, error)) {
+        return false;
+    }
+
+    takeStart = -1.0;
+    nextFrame = 0;
+    wallStart = 0;
+
+    if (source != SOURCE_HOST_BOUNCE) {
+        state = STATE_RENDERING;
+    }
+
+    return true;
+}
+
+void
+OfflineExporter::endTake()
+{
+    // Frames still being read back are part of the take
+    readback->flush();
+    readback->release();
+
+    // A video stream may only fail once its queue is written out
+    juce::String closeError;
+    if (!writer.close(closeError) && !writeFailed.load()) {
+        writeError = closeError;
+        writeFailed = true;
+    }
+
+    engine->setParameterOverride(nullptr);
+    engine->release();
+#if JUCE_LINUX || JUCE_WINDOWS
+    context->release();
+#endif
+}
+
+bool
+OfflineExporter::runHostBounce(juce::String &error) // OUT
+{
+    while (!threadShouldExit()) {
+        if (!blockReady.wait(50)) {
+            continue;
+        }
+
+        if (hostRealtimeAgain.load() || threadShouldExit()) {
+            break;
+        }
+
+        bool processed = processBlock(hostBlock.timestamp, hostBlock.sampleRate,
+                                      *hostBlock.buffer, *hostBlock.midiBuffer, error);
+        blockDone.signal();
+
+        if (!processed) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+OfflineExporter::runFile(juce::String &error) // OUT
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(inputFile));
+    if (reader == nullptr || reader->sampleRate <= 0.0) {
+        error = "Could not read " + inputFile.getFullPathName();
+        return false;
+    }
+
+    const double sampleRate = reader->sampleRate;
+    const juce::int64 length = reader->lengthInSamples;
+    totalSeconds = (double)length / sampleRate;
+
+    /*
+     * Midi comes from a .mid file with the same name, if there is one.
+     */
+    juce::MidiMessageSequence midi;
+    juce::File midiFile = inputFile.withFileExtension("mid");
+    if (midiFile.existsAsFile()) {
+        juce::FileInputStream in(midiFile);
+        juce::MidiFile file;
+
+        if (!in.openedOk() || !file.readFrom(in)) {
+            error = "Could not read " + midiFile.getFullPathName();
+            return false;
+        }
+
+        file.convertTimestampTicksToSeconds();
+        for (int i = 0; i < file.getNumTracks(); i++) {
+            midi.addSequence(*file.getTrack(i), 0.0);
+        }
+    }
+
+    juce::AudioBuffer<float> buffer(juce::jlimit(1, 2, (int)reader->numChannels), FILE_BLOCK_SIZE);
+    juce::MidiBuffer midiBuffer;
+    int midiIdx = 0;
+
+    for (juce::int64 pos = 0; pos < length && !threadShouldExit(); pos += FILE_BLOCK_SIZE) {
+        int numSamples = (int)juce::jmin((juce::int64)FILE_BLOCK_SIZE, length - pos);
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+        reader->read(&buffer, 0, numSamples, pos, true, true);
+
+        midiBuffer.clear();
+        while (midiIdx < midi.getNumEvents()) {
+            const juce::MidiMessage &message = midi.getEventPointer(midiIdx)->message;
+            juce::int64 samplePos = (juce::int64)std::llround(message.getTimeStamp() * sampleRate);
+            if (samplePos >= pos + numSamples) {
+                break;
+            }
+
+            midiBuffer.addEvent(message, (int)juce::jmax((juce::int64)0, samplePos - pos));
+            midiIdx++;
+        }
+
+        if (!processBlock((double)pos / sampleRate, sampleRate, buffer, midiBuffer, error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * OfflineExporter::runCapture
+ *    Replays a capture block by block. Parameter changes recorded ahead
+ *    of a block apply to the frames rendered while it is fed, as they
+ *    did when it was recorded.
+ */
+bool
+OfflineExporter::runCapture(juce::String &error) // OUT
+{
+    CaptureReader reader;
+    if (!reader.open(inputFile, error)) {
+        return false;
+    }
+
+    replayParameters.clear();
+    engine->setParameterOverride(&replayParameters);
+
+    CaptureReader::Block block;
+    while (!threadShouldExit()) {
+        CaptureReader::Result result = reader.readBlock(block, replayParameters, error);
+        if (result == CaptureReader::RESULT_ERROR) {
+            return false;
+        }
+        if (result == CaptureReader::RESULT_END) {
+            break;
+        }
+
+        if (!processBlock(block.timestamp, block.sampleRate, block.buffer, block.midiBuffer,
+                          error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * OfflineExporter::processBlock
+ *    Feeds one block to the engine in slices of at most
+ *    MAX_SLICE_SECONDS, rendering every frame that falls due along the
+ *    way. A frame is rendered as soon as the audio reaches its time, so
+ *    the engine never holds more than one slice past it.
+ */
+bool
+OfflineExporter::processBlock(double timestamp,                 // IN
+                              double sampleRate,                // IN
+                              juce::AudioBuffer<float> &buffer, // IN
+                              juce::MidiBuffer &midiBuffer,     // IN
+                              juce::String &error)              // OUT
+{
+    if (takeStart < 0.0) {
+        takeStart = timestamp;
+        state = STATE_RENDERING;
+    }
+
+    const double blockStart = timestamp - takeStart;
+    const int numSamples = buffer.getNumSamples();
+    const int sliceSize = juce::jmax(1, (int)(sampleRate * MAX_SLICE_SECONDS));
+
+    for (int pos = 0; pos < numSamples; pos += sliceSize) {
+        int len = juce::jmin(sliceSize, numSamples - pos);
+        juce::AudioBuffer<float> slice(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                       pos, len);
+
+        sliceMidi.clear();
+        sliceMidi.addEvents(midiBuffer, pos, len, -pos);
+
+        engine->feedAudio(blockStart + pos / sampleRate, sampleRate, slice, sliceMidi);
+        if (!renderDueFrames(blockStart + (pos + len) / sampleRate, error)) {
+            return false;
+        }
+    }
+
+    secondsRendered = blockStart + numSamples / sampleRate;
+    return true;
+}
+
+bool
+OfflineExporter::renderDueFrames(double fedUntil,    // IN
+                                 juce::String &error) // OUT
+{
+    while (!threadShouldExit()) {
+        // Computed from the frame number, so no error accumulates
+        double frameTime = (double)nextFrame / settings.fps;
+        if (frameTime > fedUntil) {
+            break;
+        }
+
+        if (wallStart == 0) {
+            wallStart = juce::Time::getHighResolutionTicks();
+        } else if (settings.realTime) {
+            waitForWallClock(frameTime);
+        }
+
+        engine->renderFrame(settings.width, settings.height, frameTime, frameTime);
+        if (!engine->isValid()) {
+            error = getLastError().isNotEmpty() ? getLastError()
+                                                : juce::String("The renderer stopped");
+            return false;
+        }
+
+        /*
+         * Blocking: when the writer falls behind, rendering waits for it
+         * rather than dropping frames.
+         */
+        readback->capture(engine->getOutputFramebuffer(),
+                          juce::jmin(engine->getOutputWidth(), settings.width),
+                          juce::jmin(engine->getOutputHeight(), settings.height),
+                          (juce::uint64)nextFrame, true);
+        readback->poll();
+
+        if (writeFailed.load()) {
+            error = writeError;
+            return false;
+        }
+
+        nextFrame++;
+        wallSeconds = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - wallStart);
+    }
+
+    return true;
+}
+
+/*
+ * OfflineExporter::waitForWallClock
+ *    Holds the frame due frameTime into the take until that long after
+ *    the first frame, in short waits so stop isn't held up.
+ */
+void
+OfflineExporter::waitForWallClock(double frameTime) // IN
+{
+    while (!threadShouldExit()) {
+        double ahead = frameTime - juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - wallStart);
+        if (ahead <= 0.0) {
+            break;
+        }
+
+        wait(juce::jlimit(1, 50, (int)(ahead * 1000.0)));
+    }
+}
+
+/*
+ * OfflineExporter::writeFrame
+ *    Called on the readback worker with each frame in order. Output
+ *    smaller than the export size (a fixed size output shader) sits in
+ *    the lower left corner on black. A frame that couldn't be mapped
+ *    fails the take rather than being written out black.
+ */
+void
+OfflineExporter::writeFrame(const FrameReadback::Frame &frame) // IN
+{
+    if (writeFailed.load()) {
+        return;
+    }
+
+    const juce::uint8 *framePixels = frame.pixels;
+
+    if (framePixels == nullptr && frame.width > 0 && frame.height > 0) {
+        writeError = "Could not read back frame " + juce::String((juce::int64)frame.number) +
+                     " from the GPU";
+        writeFailed = true;
+        return;
+    }
+
+    if (framePixels == nullptr || frame.width != settings.width ||
+        frame.height != settings.height) {
+        pixels.assign((size_t)settings.width * settings.height * 4, 0);
+
+        for (int y = 0; framePixels != nullptr && y < frame.height; y++) {
+            memcpy(pixels.data() + (size_t)y * settings.width * 4,
+                   framePixels + (size_t)y * frame.width * 4,
+                   (size_t)frame.width * 4);
+        }
+        framePixels = pixels.data();
+    }
+
+    if (!writer.writeFrame(framePixels, writeError)) {
+        writeFailed = true;
+        return;
+    }
+
+    numFramesWritten = writer.getNumFramesWritten();
+}
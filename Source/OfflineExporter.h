@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    OfflineExporter.h
+    Created: 16 Oct 2026 11:29:05pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "RenderEngine.h"
+#include "FrameReadback.h"
+#include "FrameWriter.h"
+
+class HeadlessContext;
+
+/*
+ * OfflineExporter
+ *    Renders the visualization to disk as fast as the GPU allows, on its
+ *    own thread with its own headless context and RenderEngine. Audio
+ *    and midi come from the host's offline render (a bounce,
+ *    processBlock with isNonRealtime() set), from an audio file with an
+ *    optional midi file next to it, or from an input capture (see
+ *    InputRecorder), which also replays parameter changes.
+ *
+ *    Frames are stepped at a fixed rate: frame k shows the audio at
+ *    exactly k / fps seconds into the take, and the engine is fed audio
+ *    in slices so each frame sees the same input however long it took
+ *    to render. Nothing depends on the wall clock, so rendering the same
+ *    project twice produces identical frames.
+ *
+ *    During a bounce the audio thread waits for the frames due in each
+ *    block, which is fine for the host since it isn't running in real
+ *    time. Realtime blocks are ignored; the take ends when the host
+ *    goes back to realtime or stop is called.
+ */
+class OfflineExporter : public ShadertoyAudioProcessor::AudioListener,
+                        private juce::Thread,
+                        private juce::AsyncUpdater
+{
+public:
+    struct Settings
+    {
+        juce::File destination; // PNG sequence directory, video file or named pipe; unused when discarding
+        int format = FrameWriter::FORMAT_PNG_SEQUENCE;
+        int width = 1280;
+        int height = 720;
+        double fps = 60.0;
+        bool realTime = false; // Pace frames to the wall clock (not for bounces)
+    };
+
+    enum State {
+        STATE_IDLE,
+        STATE_ARMED,     // Waiting for the host to start a bounce
+        STATE_RENDERING,
+        STATE_FINISHED,
+        STATE_FAILED
+    };
+
+    OfflineExporter(ShadertoyAudioProcessor &processor);
+    ~OfflineExporter() override;
+
+    /*
+     * Message thread. Both return false with a reason in error if the
+     * export can't be started (e.g. one is already running).
+     */
+    bool armHostBounce(const Settings &settings, juce::String &error);
+    bool renderFile(const Settings &settings, const juce::File &audioFile,
+                    juce::String &error);
+    bool renderCapture(const Settings &settings, const juce::File &captureFile,
+                       juce::String &error);
+    void stop();
+
+    State getState() const { return state.load(); }
+    int getNumFramesWritten() const { return numFramesWritten.load(); }
+    double getSecondsRendered() const { return secondsRendered.load(); }
+    double getTotalSeconds() const { return totalSeconds.load(); } // 0 if unknown
+    double getWallSeconds() const { return wallSeconds.load(); }     // Since the first frame
+    VideoSink::Stats getStreamStats() const { return writer.getStreamStats(); }
+    juce::String getLastError() const;
+
+    void handleAudioFrame(double timestamp, double sampleRate,
+                          juce::AudioBuffer<float>& buffer,
+                          juce::MidiBuffer &midiBuffer) override;
+
+    static constexpr double MIN_FPS = 1.0;
+    static constexpr double MAX_FPS = 240.0;
+
+private:
+    /*
+     * A host block handed from the audio thread, which waits until it
+     * has been rendered.
+     */
+    struct HostBlock
+    {
+        double timestamp = 0.0;
+        double sampleRate = 0.0;
+        juce::AudioBuffer<float> *buffer = nullptr;
+        juce::MidiBuffer *midiBuffer = nullptr;
+    };
+
+    enum Source {
+        SOURCE_HOST_BOUNCE,
+        SOURCE_AUDIO_FILE,
+        SOURCE_CAPTURE
+    };
+
+    bool start(const Settings &settings, Source source, const juce::File &file,
+               juce::String &error);
+    void run() override;
+    void handleAsyncUpdate() override;
+    bool beginTake(juce::String &error);
+    void endTake();
+    bool runHostBounce(juce::String &error);
+    bool runFile(juce::String &error);
+    bool runCapture(juce::String &error);
+    bool processBlock(double timestamp, double sampleRate,
+                      juce::AudioBuffer<float> &buffer,
+                      juce::MidiBuffer &midiBuffer, juce::String &error);
+    bool renderDueFrames(double fedUntil, juce::String &error);
+    void waitForWallClock(double frameTime);
+    void writeFrame(const FrameReadback::Frame &frame);
+    void setFailed(const juce::String &error);
+
+    /*
+     * Longest slice of audio fed to the engine between frame checks.
+     * Must stay below RenderEngine::DELAY_LATENCY (16 ms), the most the
+     * engine can look back from its newest sample.
+     */
+    static constexpr double MAX_SLICE_SECONDS = 0.005;
+
+    /*
+     * Block size used when reading an audio file.
+     */
+    static constexpr int FILE_BLOCK_SIZE = 1024;
+
+    ShadertoyAudioProcessor &processor;
+    Settings settings;
+    Source source = SOURCE_HOST_BOUNCE;
+    juce::File inputFile; // Audio file or capture
+
+#if JUCE_LINUX || JUCE_WINDOWS
+    std::unique_ptr<HeadlessContext> context; // Kept out of the header, EGL pulls in X11
+#endif
+    std::unique_ptr<RenderEngine> engine;
+    std::unique_ptr<FrameReadback> readback;
+    juce::MidiBuffer sliceMidi;
+    std::vector<float> replayParameters; // Captures only, see RenderEngine::setParameterOverride
+
+    /*
+     * Readback worker thread only. pixels pads frames smaller than the
+     * export size.
+     */
+    FrameWriter writer;
+    std::vector<juce::uint8> pixels;
+    std::atomic<bool> writeFailed { false };
+    juce::String writeError;
+
+    /*
+     * Take state, render thread only. Timestamps are rebased so the take
+     * starts at 0, whatever the host's clock said.
+     */
+    double takeStart = -1.0;
+    juce::int64 nextFrame = 0;
+    juce::int64 wallStart = 0; // High resolution ticks at the first frame
+
+    /*
+     * Audio thread <-> render thread hand-off during a bounce.
+     */
+    HostBlock hostBlock;
+    juce::WaitableEvent blockReady;
+    juce::WaitableEvent blockDone;
+    std::atomic<bool> hostRealtimeAgain { false };
+    std::atomic<bool> listening { false };
+
+    std::atomic<State> state { STATE_IDLE };
+    std::atomic<int> numFramesWritten { 0 };
+    std::atomic<double> secondsRendered { 0.0 };
+    std::atomic<double> totalSeconds { 0.0 };
+    std::atomic<double> wallSeconds { 0.0 };
+    mutable juce::SpinLock errorLock;
+    juce::String lastError;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineExporter)
+};
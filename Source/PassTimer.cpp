@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    PassTimer.cpp
+    Created: 16 Oct 2026 8:14:09pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PassTimer.h"
+
+PassTimer::PassTimer()
+{
+}
+
+PassTimer::~PassTimer()
+{
+}
+
+bool
+PassTimer::initialise()
+{
+    glGenQueries = (PFNGLGENQUERIESPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGenQueries");
+    glDeleteQueries = (PFNGLDELETEQUERIESPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glDeleteQueries");
+    glBeginQuery = (PFNGLBEGINQUERYPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glBeginQuery");
+    glEndQuery = (PFNGLENDQUERYPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glEndQuery");
+    glGetQueryObjectiv = (PFNGLGETQUERYOBJECTIVPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGetQueryObjectiv");
+    glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGetQueryObjectui64v");
+
+    available = glGenQueries != nullptr && glDeleteQueries != nullptr &&
+                glBeginQuery != nullptr && glEndQuery != nullptr &&
+                glGetQueryObjectiv != nullptr && glGetQueryObjectui64v != nullptr;
+
+    if (available) {
+        for (auto &slot : slots) {
+            glGenQueries(MAX_PASSES, slot.queries);
+        }
+    }
+
+    currentSlot = 0;
+    activePass = -1;
+    for (int i = 0; i < MAX_PASSES; i++) {
+        collectedValid[i] = false;
+        collectedTime[i] = 0.0;
+    }
+
+    return available;
+}
+
+void
+PassTimer::release()
+{
+    if (available) {
+        for (auto &slot : slots) {
+            glDeleteQueries(MAX_PASSES, slot.queries);
+        }
+    }
+
+    for (auto &slot : slots) {
+        slot = Slot();
+    }
+
+    available = false;
+}
+
+void
+PassTimer::beginFrame(juce::uint64 frameNumber) // IN
+{
+    if (!available) {
+        return;
+    }
+
+    Slot &slot = slots[currentSlot];
+    collectedFrame = slot.frameNumber;
+    slot.frameNumber = frameNumber;
+
+    for (int i = 0; i < MAX_PASSES; i++) {
+        collectedValid[i] = false;
+
+        if (!slot.issued[i]) {
+            continue;
+        }
+
+        /*
+         * A result that still isn't ready FRAMES_IN_FLIGHT frames later is
+         * dropped rather than waited on, since the query is about to be
+         * reused.
+         */
+        GLint ready = 0;
+        glGetQueryObjectiv(slot.queries[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (ready) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &nanoseconds);
+            collectedTime[i] = (double)nanoseconds * 1e-9;
+            collectedValid[i] = true;
+        }
+
+        slot.issued[i] = false;
+    }
+}
+
+void
+PassTimer::endFrame()
+{
+    jassert(activePass < 0);
+    currentSlot = (currentSlot + 1) % FRAMES_IN_FLIGHT;
+}
+
+void
+PassTimer::beginPass(int passId) // IN
+{
+    jassert(passId >= 0 && passId < MAX_PASSES);
+    jassert(activePass < 0);
+
+    if (!available) {
+        return;
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, slots[currentSlot].queries[passId]);
+    activePass = passId;
+}
+
+void
+PassTimer::endPass()
+{
+    if (activePass < 0) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    slots[currentSlot].issued[activePass] = true;
+    activePass = -1;
+}
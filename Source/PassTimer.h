@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    PassTimer.h
+    Created: 16 Oct 2026 8:14:09pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "glext.h"
+
+/*
+ * PassTimer
+ *    Measures the GPU time of each render pass with GL_TIME_ELAPSED
+ *    queries. Queries are kept in a ring a few frames deep and only read
+ *    once the driver reports them available, so timing never stalls the
+ *    pipeline; results are simply a few frames old. Pass ids are chosen
+ *    by the caller. GL thread only.
+ */
+class PassTimer
+{
+public:
+    PassTimer();
+    ~PassTimer();
+
+    /*
+     * Needs a current context. Returns false (and times nothing) if the
+     * driver has no timer queries.
+     */
+    bool initialise();
+    void release();
+    bool isAvailable() const
+      { return available; }
+
+    /*
+     * Collects whatever results have arrived for the oldest frame in the
+     * ring, then starts recording frameNumber into that slot.
+     */
+    void beginFrame(juce::uint64 frameNumber);
+    void endFrame();
+
+    /*
+     * Passes may not nest.
+     */
+    void beginPass(int passId);
+    void endPass();
+
+    /*
+     * Result of the most recently collected frame, in seconds. Passes
+     * that weren't rendered in that frame (or whose result was dropped)
+     * report false from hasPassTime.
+     */
+    bool hasPassTime(int passId) const
+      { return collectedValid[passId]; }
+    double getPassTime(int passId) const
+      { return collectedTime[passId]; }
+
+    /*
+     * The frame number the collected results belong to.
+     */
+    juce::uint64 getCollectedFrame() const
+      { return collectedFrame; }
+
+    static constexpr int MAX_PASSES = 32;
+    static constexpr int FRAMES_IN_FLIGHT = 4;
+
+private:
+    struct Slot {
+        GLuint queries[MAX_PASSES] = { };
+        bool issued[MAX_PASSES] = { };
+        juce::uint64 frameNumber = 0;
+    };
+
+    Slot slots[FRAMES_IN_FLIGHT];
+    int currentSlot = 0;
+    int activePass = -1;
+    bool available = false;
+
+    bool collectedValid[MAX_PASSES] = { };
+    double collectedTime[MAX_PASSES] = { };
+    juce::uint64 collectedFrame = 0;
+
+    PFNGLGENQUERIESPROC glGenQueries = nullptr;
+    PFNGLDELETEQUERIESPROC glDeleteQueries = nullptr;
+    PFNGLBEGINQUERYPROC glBeginQuery = nullptr;
+    PFNGLENDQUERYPROC glEndQuery = nullptr;
+    PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv = nullptr;
+    PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PassTimer)
+};
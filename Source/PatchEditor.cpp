@@ -9,6 +9,8 @@
 #include <JuceHeader.h>
 #include "PatchEditor.h"
 #include "PluginEditor.h"
+#include "OfflineExporter.h"
+#include "InputRecorder.h"
 
 
 PatchEditor::PatchEditor(ShadertoyAudioProcessorEditor &editor, // IN / OUT
@@ -83,6 +85,11 @@ void
 PatchEditor::processorStateChanged()
 {
     globalPropertiesComponent.updateVisuSize();
+    globalPropertiesComponent.updateBuffers();
+    globalPropertiesComponent.updateDynamicResolution();
+    globalPropertiesComponent.updateFramePacing();
+    globalPropertiesComponent.updateExport();
+    shaderPropertiesComponent.updateDestinations();
 }
 
 PatchEditor::ShaderListBoxModel::ShaderListBoxModel(
@@ -337,7 +344,8 @@ PatchEditor::ShaderPropertiesComponent::ShaderPropertiesComponent(
    processor(processor),
    parent(parent),
    shaderListComponent(shaderListComponent),
-   fixedSizeButton("Fixed Size Framebuffer")
+   fixedSizeButton("Fixed Size Framebuffer"),
+   mipmapsButton("Generate Mipmaps")
 {
     addAndMakeVisible(shaderPropertiesLabel);
     shaderPropertiesLabel.setText("Shader Properties", juce::NotificationType::dontSendNotification);
@@ -363,16 +371,74 @@ PatchEditor::ShaderPropertiesComponent::ShaderPropertiesComponent(
     fixedSizeHeightLabel.setText("Height:", juce::NotificationType::dontSendNotification);
 
     addAndMakeVisible(destinationBox);
-    destinationBox.addItem("Output", 1);
-    destinationBox.addItem("Buffer A", 2);
-    destinationBox.addItem("Buffer B", 3);
-    destinationBox.addItem("Buffer C", 4);
-    destinationBox.addItem("Buffer D", 5);
+    updateDestinations();
     destinationBox.setEnabled(false);
     destinationBox.addListener(this);
 
     addAndMakeVisible(destinationLabel);
     destinationLabel.setText("Destination:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(formatBox);
+    formatBox.addItem("RGB8", ShadertoyAudioProcessor::FORMAT_RGB8);
+    formatBox.addItem("RGBA8", ShadertoyAudioProcessor::FORMAT_RGBA8);
+    formatBox.addItem("R8", ShadertoyAudioProcessor::FORMAT_R8);
+    formatBox.addItem("R16F", ShadertoyAudioProcessor::FORMAT_R16F);
+    formatBox.addItem("RGBA16F", ShadertoyAudioProcessor::FORMAT_RGBA16F);
+    formatBox.addItem("R32F", ShadertoyAudioProcessor::FORMAT_R32F);
+    formatBox.addItem("RGBA32F", ShadertoyAudioProcessor::FORMAT_RGBA32F);
+    formatBox.setEnabled(false);
+    formatBox.addListener(this);
+
+    addAndMakeVisible(formatLabel);
+    formatLabel.setText("Format:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(filterBox);
+    filterBox.addItem("Nearest", ShadertoyAudioProcessor::FILTER_NEAREST);
+    filterBox.addItem("Linear", ShadertoyAudioProcessor::FILTER_LINEAR);
+    filterBox.setEnabled(false);
+    filterBox.addListener(this);
+
+    addAndMakeVisible(filterLabel);
+    filterLabel.setText("Filter:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(wrapBox);
+    wrapBox.addItem("Clamp", ShadertoyAudioProcessor::WRAP_CLAMP);
+    wrapBox.addItem("Repeat", ShadertoyAudioProcessor::WRAP_REPEAT);
+    wrapBox.addItem("Mirror", ShadertoyAudioProcessor::WRAP_MIRROR);
+    wrapBox.setEnabled(false);
+    wrapBox.addListener(this);
+
+    addAndMakeVisible(wrapLabel);
+    wrapLabel.setText("Wrap:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(mipmapsButton);
+    mipmapsButton.addListener(this);
+
+    addAndMakeVisible(targetsBox);
+    for (int i = 1; i <= ShadertoyAudioProcessor::MAX_RENDER_TARGETS; i++) {
+        targetsBox.addItem(std::to_string(i), i);
+    }
+    targetsBox.setEnabled(false);
+    targetsBox.addListener(this);
+
+    addAndMakeVisible(targetsLabel);
+    targetsLabel.setText("Targets:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(updateDivisorEditor);
+    updateDivisorEditor.setMultiLine(false);
+    updateDivisorEditor.setInputRestrictions(3, "0123456789");
+    updateDivisorEditor.addListener(this);
+
+    addAndMakeVisible(updateDivisorLabel);
+    updateDivisorLabel.setText("Update Every (frames):", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(updateHzEditor);
+    updateHzEditor.setMultiLine(false);
+    updateHzEditor.setInputRestrictions(6, "0123456789.");
+    updateHzEditor.addListener(this);
+
+    addAndMakeVisible(updateHzLabel);
+    updateHzLabel.setText("Update Rate (Hz, 0 = off):", juce::NotificationType::dontSendNotification);
     
     parent.greyOutTopRightRegion();
 }
@@ -415,6 +481,30 @@ PatchEditor::ShaderPropertiesComponent::resized()
                                90, 20);
     destinationBox.setBounds(destinationLabel.getX() + destinationLabel.getWidth(),
                              destinationLabel.getY(), 100, 20);
+
+    updateDivisorLabel.setBounds(padding, destinationLabel.getBottom() + spacing, 165, 20);
+    updateDivisorEditor.setBounds(updateDivisorLabel.getRight(), updateDivisorLabel.getY(), 50, 20);
+
+    updateHzLabel.setBounds(padding, updateDivisorLabel.getBottom() + spacing, 165, 20);
+    updateHzEditor.setBounds(updateHzLabel.getRight(), updateHzLabel.getY(), 50, 20);
+
+    /*
+     * Texture settings go in a second column
+     */
+    int column = destinationBox.getRight() + 4 * spacing;
+    formatLabel.setBounds(column, fixedSizeButton.getY(), 65, 20);
+    formatBox.setBounds(formatLabel.getRight(), formatLabel.getY(), 100, 20);
+
+    filterLabel.setBounds(column, formatLabel.getBottom() + spacing, 65, 20);
+    filterBox.setBounds(filterLabel.getRight(), filterLabel.getY(), 100, 20);
+
+    wrapLabel.setBounds(column, filterLabel.getBottom() + spacing, 65, 20);
+    wrapBox.setBounds(wrapLabel.getRight(), wrapLabel.getY(), 100, 20);
+
+    targetsLabel.setBounds(column, wrapLabel.getBottom() + spacing, 65, 20);
+    targetsBox.setBounds(targetsLabel.getRight(), targetsLabel.getY(), 100, 20);
+
+    mipmapsButton.setBounds(column, targetsLabel.getBottom() + spacing, 175, 20);
 }
 
 void
@@ -428,6 +518,11 @@ PatchEditor::ShaderPropertiesComponent::buttonClicked(juce::Button *button) // I
         }
         processor.setShaderFixedSizeBuffer(shaderListComponent.getSelectedRow(),
                                            fixedSizeButton.getToggleState());
+    } else if (button == &mipmapsButton) {
+        int shaderIdx = shaderListComponent.getSelectedRow();
+        ShadertoyAudioProcessor::BufferTexture texture = processor.getShaderTexture(shaderIdx);
+        texture.mipmaps = mipmapsButton.getToggleState();
+        processor.setShaderTexture(shaderIdx, texture);
     }
 }
 
@@ -499,6 +594,19 @@ PatchEditor::ShaderPropertiesComponent::greyOut()
 
     destinationBox.setEnabled(false);
     destinationBox.setSelectedId(0, juce::NotificationType::dontSendNotification);
+
+    for (juce::ComboBox *box : { &formatBox, &filterBox, &wrapBox, &targetsBox }) {
+        box->setEnabled(false);
+        box->setSelectedId(0, juce::NotificationType::dontSendNotification);
+    }
+
+    mipmapsButton.setEnabled(false);
+    mipmapsButton.setToggleState(false, juce::NotificationType::dontSendNotification);
+
+    for (juce::TextEditor *textEditor : { &updateDivisorEditor, &updateHzEditor }) {
+        textEditor->setReadOnly(true);
+        textEditor->setText("", false);
+    }
 }
 
 void
@@ -522,6 +630,42 @@ PatchEditor::ShaderPropertiesComponent::load(int shaderIdx) // IN
     destinationBox.setEnabled(true);
     destinationBox.setSelectedId(processor.getShaderDestination(shaderIdx),
                                  juce::NotificationType::dontSendNotification);
+
+    const ShadertoyAudioProcessor::BufferTexture &texture = processor.getShaderTexture(shaderIdx);
+    formatBox.setEnabled(true);
+    formatBox.setSelectedId(texture.format, juce::NotificationType::dontSendNotification);
+    filterBox.setEnabled(true);
+    filterBox.setSelectedId(texture.filter, juce::NotificationType::dontSendNotification);
+    wrapBox.setEnabled(true);
+    wrapBox.setSelectedId(texture.wrap, juce::NotificationType::dontSendNotification);
+    targetsBox.setEnabled(true);
+    targetsBox.setSelectedId(texture.numTargets, juce::NotificationType::dontSendNotification);
+    mipmapsButton.setEnabled(true);
+    mipmapsButton.setToggleState(texture.mipmaps, juce::NotificationType::dontSendNotification);
+
+    updateDivisorEditor.setReadOnly(false);
+    updateDivisorEditor.setText(std::to_string(processor.getShaderUpdateDivisor(shaderIdx)), false);
+    updateHzEditor.setReadOnly(false);
+    updateHzEditor.setText(juce::String(processor.getShaderUpdateHz(shaderIdx)), false);
+}
+
+/*
+ * PatchEditor::ShaderPropertiesComponent::updateDestinations
+ *    Rebuilds the destination list from the processor's buffer names,
+ *    keeping the current selection.
+ */
+void
+PatchEditor::ShaderPropertiesComponent::updateDestinations()
+{
+    int selectedId = destinationBox.getSelectedId();
+
+    destinationBox.clear(juce::NotificationType::dontSendNotification);
+    destinationBox.addItem("Output", 1);
+    for (int i = 0; i < processor.getNumBuffers(); i++) {
+        destinationBox.addItem("Buffer " + processor.getBufferName(i), 2 + i);
+    }
+
+    destinationBox.setSelectedId(selectedId, juce::NotificationType::dontSendNotification);
 }
 
 void
@@ -534,6 +678,12 @@ PatchEditor::ShaderPropertiesComponent::textEditorTextChanged(
     } else if (&textEditor == &fixedSizeHeightEditor) {
         int height = textEditor.getText().getIntValue();
         processor.setShaderFixedSizeHeight(shaderListComponent.getSelectedRow(), height);
+    } else if (&textEditor == &updateDivisorEditor && textEditor.getText().isNotEmpty()) {
+        processor.setShaderUpdateDivisor(shaderListComponent.getSelectedRow(),
+                                         textEditor.getText().getIntValue());
+    } else if (&textEditor == &updateHzEditor) {
+        processor.setShaderUpdateHz(shaderListComponent.getSelectedRow(),
+                                    textEditor.getText().getDoubleValue());
     }
 }
 
@@ -544,6 +694,17 @@ PatchEditor::ShaderPropertiesComponent::comboBoxChanged(
     if (comboBoxThatHasChanged == &destinationBox) {
         int id = destinationBox.getSelectedId();
         processor.setShaderDestination(shaderListComponent.getSelectedRow(), id);
+    } else if (comboBoxThatHasChanged == &formatBox ||
+               comboBoxThatHasChanged == &filterBox ||
+               comboBoxThatHasChanged == &wrapBox ||
+               comboBoxThatHasChanged == &targetsBox) {
+        int shaderIdx = shaderListComponent.getSelectedRow();
+        ShadertoyAudioProcessor::BufferTexture texture = processor.getShaderTexture(shaderIdx);
+        texture.format = formatBox.getSelectedId();
+        texture.filter = filterBox.getSelectedId();
+        texture.wrap = wrapBox.getSelectedId();
+        texture.numTargets = targetsBox.getSelectedId();
+        processor.setShaderTexture(shaderIdx, texture);
     }
 }
 
@@ -553,7 +714,14 @@ PatchEditor::GlobalPropertiesComponent::GlobalPropertiesComponent(
     PatchEditor &parent)                   // IN / OUT
  : editor(editor),
    processor(processor),
-   parent(parent)
+   parent(parent),
+   dynamicResolutionButton("Dynamic Resolution"),
+   exportBounceButton("Arm Host Bounce"),
+   exportFileButton("Render Audio File"),
+   exportStopButton("Stop"),
+   captureRecordButton("Record Input"),
+   captureReplayButton("Replay Capture"),
+   captureRealTimeButton("Real Time")
 {
     addAndMakeVisible(globalPropertiesLabel);
     globalPropertiesLabel.setText("Global Properties", juce::NotificationType::dontSendNotification);
@@ -576,6 +744,106 @@ PatchEditor::GlobalPropertiesComponent::GlobalPropertiesComponent(
 
     addAndMakeVisible(visuHeightLabel);
     visuHeightLabel.setText("Visualization Height:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(numBuffersEditor);
+    numBuffersEditor.setMultiLine(false);
+    numBuffersEditor.setInputRestrictions(2, "0123456789");
+    numBuffersEditor.addListener(this);
+
+    addAndMakeVisible(numBuffersLabel);
+    numBuffersLabel.setText("Buffers:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(bufferNamesEditor);
+    bufferNamesEditor.setMultiLine(false);
+    bufferNamesEditor.addListener(this);
+
+    addAndMakeVisible(bufferNamesLabel);
+    bufferNamesLabel.setText("Buffer Names:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(dynamicResolutionButton);
+    dynamicResolutionButton.addListener(this);
+
+    addAndMakeVisible(targetFpsEditor);
+    targetFpsEditor.setMultiLine(false);
+    targetFpsEditor.setInputRestrictions(3, "0123456789");
+    targetFpsEditor.addListener(this);
+
+    addAndMakeVisible(targetFpsLabel);
+    targetFpsLabel.setText("Target FPS:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(minScaleEditor);
+    minScaleEditor.setMultiLine(false);
+    minScaleEditor.setInputRestrictions(3, "0123456789");
+    minScaleEditor.addListener(this);
+
+    addAndMakeVisible(minScaleLabel);
+    minScaleLabel.setText("Min Scale (%):", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(frameRateLimitEditor);
+    frameRateLimitEditor.setMultiLine(false);
+    frameRateLimitEditor.setInputRestrictions(3, "0123456789");
+    frameRateLimitEditor.addListener(this);
+
+    addAndMakeVisible(frameRateLimitLabel);
+    frameRateLimitLabel.setText("FPS Limit (0 = off):", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(framesInFlightEditor);
+    framesInFlightEditor.setMultiLine(false);
+    framesInFlightEditor.setInputRestrictions(1, "12");
+    framesInFlightEditor.addListener(this);
+
+    addAndMakeVisible(framesInFlightLabel);
+    framesInFlightLabel.setText("Frames In Flight:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(exportFpsEditor);
+    exportFpsEditor.setMultiLine(false);
+    exportFpsEditor.setInputRestrictions(3, "0123456789");
+    exportFpsEditor.addListener(this);
+
+    addAndMakeVisible(exportFpsLabel);
+    exportFpsLabel.setText("Export FPS:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(exportFormatBox);
+    exportFormatBox.addItem("PNG Sequence", FrameWriter::FORMAT_PNG_SEQUENCE);
+    exportFormatBox.addItem("Raw RGBA Video", FrameWriter::FORMAT_RAW_RGBA);
+    exportFormatBox.addItem("Y4M Video", FrameWriter::FORMAT_Y4M);
+    exportFormatBox.addItem("Raw I420 Video", FrameWriter::FORMAT_RAW_I420);
+    exportFormatBox.addItem("Raw NV12 Video", FrameWriter::FORMAT_RAW_NV12);
+    exportFormatBox.addItem("None (Benchmark)", FrameWriter::FORMAT_DISCARD);
+    exportFormatBox.addListener(this);
+
+    addAndMakeVisible(exportFormatLabel);
+    exportFormatLabel.setText("Export Format:", juce::NotificationType::dontSendNotification);
+
+    addAndMakeVisible(exportBounceButton);
+    exportBounceButton.addListener(this);
+
+    addAndMakeVisible(exportFileButton);
+    exportFileButton.addListener(this);
+
+    addAndMakeVisible(exportStopButton);
+    exportStopButton.addListener(this);
+
+    addAndMakeVisible(exportStatusLabel);
+
+    addAndMakeVisible(captureRecordButton);
+    captureRecordButton.addListener(this);
+
+    addAndMakeVisible(captureReplayButton);
+    captureReplayButton.addListener(this);
+
+    addAndMakeVisible(captureRealTimeButton);
+
+    addAndMakeVisible(captureStatusLabel);
+
+    updateBuffers();
+    updateDynamicResolution();
+    updateFramePacing();
+    updateExport();
+
+    // Export progress is made on another thread, with no notification
+    timerCallback();
+    startTimerHz(4);
 }
 
 void
@@ -602,6 +870,292 @@ PatchEditor::GlobalPropertiesComponent::resized()
                               150, 20);
     visuHeightEditor.setBounds(visuHeightLabel.getX() + visuHeightLabel.getWidth(),
                                visuHeightLabel.getY(), 75, 20);
+
+    numBuffersLabel.setBounds(padding,
+                              visuHeightLabel.getY() + visuHeightLabel.getHeight() + spacing,
+                              150, 20);
+    numBuffersEditor.setBounds(numBuffersLabel.getX() + numBuffersLabel.getWidth(),
+                               numBuffersLabel.getY(), 75, 20);
+
+    bufferNamesLabel.setBounds(padding,
+                               numBuffersLabel.getY() + numBuffersLabel.getHeight() + spacing,
+                               150, 20);
+    bufferNamesEditor.setBounds(bufferNamesLabel.getX() + bufferNamesLabel.getWidth(),
+                                bufferNamesLabel.getY(),
+                                juce::jmax(75, getWidth() - bufferNamesLabel.getRight() - padding), 20);
+
+    dynamicResolutionButton.setBounds(padding,
+                                      bufferNamesLabel.getY() + bufferNamesLabel.getHeight() + spacing,
+                                      175, 20);
+
+    targetFpsLabel.setBounds(padding,
+                             dynamicResolutionButton.getY() + dynamicResolutionButton.getHeight() + spacing,
+                             150, 20);
+    targetFpsEditor.setBounds(targetFpsLabel.getX() + targetFpsLabel.getWidth(),
+                              targetFpsLabel.getY(), 75, 20);
+
+    minScaleLabel.setBounds(padding,
+                            targetFpsLabel.getY() + targetFpsLabel.getHeight() + spacing,
+                            150, 20);
+    minScaleEditor.setBounds(minScaleLabel.getX() + minScaleLabel.getWidth(),
+                             minScaleLabel.getY(), 75, 20);
+
+    frameRateLimitLabel.setBounds(padding,
+                                  minScaleLabel.getY() + minScaleLabel.getHeight() + spacing,
+                                  150, 20);
+    frameRateLimitEditor.setBounds(frameRateLimitLabel.getX() + frameRateLimitLabel.getWidth(),
+                                   frameRateLimitLabel.getY(), 75, 20);
+
+    framesInFlightLabel.setBounds(padding,
+                                  frameRateLimitLabel.getY() + frameRateLimitLabel.getHeight() + spacing,
+                                  150, 20);
+    framesInFlightEditor.setBounds(framesInFlightLabel.getX() + framesInFlightLabel.getWidth(),
+                                   framesInFlightLabel.getY(), 75, 20);
+
+    // Export controls sit in a second column, next to the frame settings
+    int column = targetFpsEditor.getRight() + 5 * padding;
+
+    exportFpsLabel.setBounds(column, dynamicResolutionButton.getY(), 150, 20);
+    exportFpsEditor.setBounds(exportFpsLabel.getX() + exportFpsLabel.getWidth(),
+                              exportFpsLabel.getY(), 75, 20);
+
+    exportFormatLabel.setBounds(column,
+                                exportFpsLabel.getY() + exportFpsLabel.getHeight() + spacing,
+                                150, 20);
+    exportFormatBox.setBounds(exportFormatLabel.getX() + exportFormatLabel.getWidth(),
+                              exportFormatLabel.getY(), 150, 20);
+
+    exportBounceButton.setBounds(column,
+                                 exportFormatLabel.getY() + exportFormatLabel.getHeight() + spacing,
+                                 140, 20);
+    exportFileButton.setBounds(exportBounceButton.getRight() + spacing,
+                               exportBounceButton.getY(), 140, 20);
+    exportStopButton.setBounds(exportFileButton.getRight() + spacing,
+                               exportBounceButton.getY(), 75, 20);
+
+    exportStatusLabel.setBounds(column,
+                                exportBounceButton.getY() + exportBounceButton.getHeight() + spacing,
+                                juce::jmax(150, getWidth() - column - padding), 20);
+
+    captureRecordButton.setBounds(column,
+                                  exportStatusLabel.getY() + exportStatusLabel.getHeight() + spacing,
+                                  140, 20);
+    captureReplayButton.setBounds(captureRecordButton.getRight() + spacing,
+                                  captureRecordButton.getY(), 140, 20);
+    captureRealTimeButton.setBounds(captureReplayButton.getRight() + spacing,
+                                    captureRecordButton.getY(), 100, 20);
+
+    captureStatusLabel.setBounds(column,
+                                 captureRecordButton.getY() + captureRecordButton.getHeight() + spacing,
+                                 juce::jmax(150, getWidth() - column - padding), 20);
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::buttonClicked(juce::Button *button) // IN
+{
+    if (button == &dynamicResolutionButton) {
+        processor.setDynamicResolution(dynamicResolutionButton.getToggleState());
+    } else if (button == &exportBounceButton) {
+        startExport(juce::File(), false);
+    } else if (button == &exportFileButton) {
+        juce::FileChooser fileChooser("Choose Audio File",
+                                      juce::File::getSpecialLocation(juce::File::userHomeDirectory),
+                                      "*.wav;*.aif;*.aiff;*.flac;*.ogg");
+        if (fileChooser.browseForFileToOpen()) {
+            startExport(fileChooser.getResult(), false);
+        }
+    } else if (button == &exportStopButton) {
+        processor.getOfflineExporter().stop();
+        timerCallback();
+    } else if (button == &captureRecordButton) {
+        toggleRecording();
+    } else if (button == &captureReplayButton) {
+        juce::FileChooser fileChooser("Choose Input Capture",
+                                      juce::File::getSpecialLocation(juce::File::userHomeDirectory),
+                                      "*.stcap");
+        if (fileChooser.browseForFileToOpen()) {
+            startExport(fileChooser.getResult(), true);
+        }
+    }
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::comboBoxChanged(
+    juce::ComboBox *comboBoxThatHasChanged) // IN
+{
+    if (comboBoxThatHasChanged == &exportFormatBox) {
+        processor.setExportFormat(exportFormatBox.getSelectedId());
+    }
+}
+
+/*
+ * PatchEditor::GlobalPropertiesComponent::chooseExportDestination
+ *    PNG sequences are written into a directory, video to a single
+ *    file. Choosing an existing named pipe streams to whatever reads it.
+ *    Discarded frames need no destination.
+ */
+bool
+PatchEditor::GlobalPropertiesComponent::chooseExportDestination(
+    juce::File &destination) // OUT
+{
+    const juce::File home = juce::File::getSpecialLocation(juce::File::userHomeDirectory);
+
+    if (processor.getExportFormat() == FrameWriter::FORMAT_DISCARD) {
+        destination = juce::File();
+    } else if (processor.getExportFormat() == FrameWriter::FORMAT_PNG_SEQUENCE) {
+        juce::FileChooser fileChooser("Choose Export Directory", home);
+        if (!fileChooser.browseForDirectory()) {
+            return false;
+        }
+        destination = fileChooser.getResult();
+    } else {
+        int format = processor.getExportFormat();
+        juce::String extension = format == FrameWriter::FORMAT_Y4M      ? "y4m"
+                               : format == FrameWriter::FORMAT_RAW_I420 ? "yuv"
+                               : format == FrameWriter::FORMAT_RAW_NV12 ? "nv12"
+                                                                        : "rgba";
+        juce::FileChooser fileChooser("Export Video", home.getChildFile("export." + extension),
+                                      "*." + extension);
+        if (!fileChooser.browseForFileToSave(true)) {
+            return false;
+        }
+        destination = fileChooser.getResult();
+    }
+
+    return true;
+}
+
+/*
+ * PatchEditor::GlobalPropertiesComponent::startExport
+ *    Renders an audio file or replays a capture, or arms the exporter
+ *    for the host's next bounce if no file is given.
+ */
+void
+PatchEditor::GlobalPropertiesComponent::startExport(const juce::File &inputFile, // IN
+                                                    bool isCapture)              // IN
+{
+    OfflineExporter::Settings settings;
+    if (!chooseExportDestination(settings.destination)) {
+        return;
+    }
+
+    settings.format = processor.getExportFormat();
+    settings.width = processor.getVisualizationWidth();
+    settings.height = processor.getVisualizationHeight();
+    settings.fps = processor.getExportFps();
+    settings.realTime = isCapture && captureRealTimeButton.getToggleState();
+
+    OfflineExporter &exporter = processor.getOfflineExporter();
+    juce::String error;
+    bool started = isCapture                 ? exporter.renderCapture(settings, inputFile, error)
+                 : inputFile != juce::File() ? exporter.renderFile(settings, inputFile, error)
+                                             : exporter.armHostBounce(settings, error);
+    if (!started) {
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                               "Offline export failed", error);
+    }
+
+    timerCallback();
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::timerCallback()
+{
+    const OfflineExporter &exporter = processor.getOfflineExporter();
+    OfflineExporter::State state = exporter.getState();
+    bool running = state == OfflineExporter::STATE_ARMED ||
+                   state == OfflineExporter::STATE_RENDERING;
+    juce::String status;
+
+    switch (state) {
+    case OfflineExporter::STATE_ARMED:
+        status = "Armed, waiting for the host to bounce";
+        break;
+    case OfflineExporter::STATE_RENDERING:
+        status = "Rendering: " + juce::String(exporter.getNumFramesWritten()) + " frames, " +
+                 juce::String(exporter.getSecondsRendered(), 1) + " s";
+        if (exporter.getTotalSeconds() > 0.0) {
+            status << " of " << juce::String(exporter.getTotalSeconds(), 1) << " s";
+        }
+        if (FrameWriter::isVideoFormat(processor.getExportFormat())) {
+            VideoSink::Stats stats = exporter.getStreamStats();
+            status << ", queue " << stats.queueDepth << "/" << stats.queueCapacity
+                   << ", " << stats.numStalls << " stalls ("
+                   << juce::String(stats.stallSeconds, 1) << " s)";
+        }
+        break;
+    case OfflineExporter::STATE_FINISHED:
+        status = "Finished: " + juce::String(exporter.getNumFramesWritten()) + " frames";
+        if (exporter.getWallSeconds() > 0.0) {
+            status << " in " << juce::String(exporter.getWallSeconds(), 2) << " s ("
+                   << juce::String(exporter.getNumFramesWritten() / exporter.getWallSeconds(), 1)
+                   << " fps)";
+        }
+        break;
+    case OfflineExporter::STATE_FAILED:
+        status = "Failed: " + exporter.getLastError();
+        break;
+    default:
+        status = "Idle";
+        break;
+    }
+
+    exportStatusLabel.setText(status, juce::NotificationType::dontSendNotification);
+    exportBounceButton.setEnabled(!running);
+    exportFileButton.setEnabled(!running);
+    exportStopButton.setEnabled(running);
+    captureReplayButton.setEnabled(!running);
+
+    const InputRecorder &recorder = processor.getInputRecorder();
+    juce::String captureStatus;
+    if (recorder.getLastError().isNotEmpty()) {
+        captureStatus = "Capture failed: " + recorder.getLastError();
+    } else if (recorder.isRecording()) {
+        captureStatus = "Recording: " + juce::String(recorder.getSecondsRecorded(), 1) + " s, " +
+                        juce::String(recorder.getNumBytesWritten() / (1024.0 * 1024.0), 1) + " MB";
+        if (recorder.getNumBlocksDropped() > 0) {
+            captureStatus << ", " << recorder.getNumBlocksDropped() << " blocks dropped";
+        }
+    } else {
+        captureStatus = "Not recording";
+    }
+
+    captureStatusLabel.setText(captureStatus, juce::NotificationType::dontSendNotification);
+    captureRecordButton.setButtonText(recorder.isRecording() ? "Stop Recording" : "Record Input");
+}
+
+/*
+ * PatchEditor::GlobalPropertiesComponent::toggleRecording
+ *    Starts capturing input to a file, or stops the capture running.
+ */
+void
+PatchEditor::GlobalPropertiesComponent::toggleRecording()
+{
+    InputRecorder &recorder = processor.getInputRecorder();
+
+    if (recorder.isRecording()) {
+        juce::String error;
+        if (!recorder.stop(error)) {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                                   "Input capture failed", error);
+        }
+    } else {
+        juce::FileChooser fileChooser("Record Input Capture",
+                                      juce::File::getSpecialLocation(juce::File::userHomeDirectory)
+                                          .getChildFile("capture.stcap"),
+                                      "*.stcap");
+        if (!fileChooser.browseForFileToSave(true)) {
+            return;
+        }
+
+        juce::String error;
+        if (!recorder.start(fileChooser.getResult(), error)) {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                                   "Input capture failed", error);
+        }
+    }
+
+    timerCallback();
 }
 
 void
@@ -614,12 +1168,125 @@ PatchEditor::GlobalPropertiesComponent::textEditorTextChanged(
     } else if (&textEditor == &visuHeightEditor) {
         int height = textEditor.getText().getIntValue();
         processor.setVisualizationHeight(height);
+    } else if (&textEditor == &targetFpsEditor && textEditor.getText().isNotEmpty()) {
+        processor.setTargetFps(juce::jmax(1, textEditor.getText().getIntValue()));
+    } else if (&textEditor == &minScaleEditor && textEditor.getText().isNotEmpty()) {
+        processor.setMinResolutionScale(juce::jlimit(5, 100, textEditor.getText().getIntValue()));
+    } else if (&textEditor == &frameRateLimitEditor && textEditor.getText().isNotEmpty()) {
+        processor.setFrameRateLimit(textEditor.getText().getIntValue());
+    } else if (&textEditor == &framesInFlightEditor && textEditor.getText().isNotEmpty()) {
+        processor.setMaxFramesInFlight(textEditor.getText().getIntValue());
+    } else if (&textEditor == &exportFpsEditor && textEditor.getText().isNotEmpty()) {
+        processor.setExportFps(textEditor.getText().getIntValue());
     }
 }
 
+void
+PatchEditor::GlobalPropertiesComponent::textEditorReturnKeyPressed(
+    juce::TextEditor &textEditor) // IN
+{
+    if (&textEditor == &bufferNamesEditor) {
+        applyBufferNames();
+    } else if (&textEditor == &numBuffersEditor) {
+        applyNumBuffers();
+    }
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::textEditorFocusLost(
+    juce::TextEditor &textEditor) // IN
+{
+    if (&textEditor == &bufferNamesEditor) {
+        applyBufferNames();
+    } else if (&textEditor == &numBuffersEditor) {
+        applyNumBuffers();
+    } else if (&textEditor == &targetFpsEditor || &textEditor == &minScaleEditor) {
+        updateDynamicResolution();
+    } else if (&textEditor == &frameRateLimitEditor || &textEditor == &framesInFlightEditor) {
+        updateFramePacing();
+    } else if (&textEditor == &exportFpsEditor) {
+        updateExport();
+    }
+}
+
+/*
+ * PatchEditor::GlobalPropertiesComponent::applyNumBuffers
+ *    Like names, the count is only committed on return or focus loss:
+ *    typing "12" would otherwise pass through 1 buffer and lose every
+ *    name after the first.
+ */
+void
+PatchEditor::GlobalPropertiesComponent::applyNumBuffers()
+{
+    if (numBuffersEditor.getText().isNotEmpty()) {
+        processor.setNumBuffers(numBuffersEditor.getText().getIntValue());
+    }
+
+    updateBuffers();
+    parent.shaderPropertiesComponent.updateDestinations();
+}
+
+/*
+ * PatchEditor::GlobalPropertiesComponent::applyBufferNames
+ *    Names are committed as a whole (not per keystroke) so a half-typed
+ *    name never clashes with another buffer. Missing or invalid names
+ *    fall back to defaults, and the editor shows what was accepted.
+ */
+void
+PatchEditor::GlobalPropertiesComponent::applyBufferNames()
+{
+    juce::StringArray names;
+    names.addTokens(bufferNamesEditor.getText(), ",", "");
+
+    while (names.size() < processor.getNumBuffers()) {
+        names.add("");
+    }
+    names.removeRange(processor.getNumBuffers(), names.size());
+
+    processor.setBufferNames(names);
+    updateBuffers();
+    parent.shaderPropertiesComponent.updateDestinations();
+}
+
 void
 PatchEditor::GlobalPropertiesComponent::updateVisuSize()
 {
     visuWidthEditor.setText(std::to_string(processor.getVisualizationWidth()), false);
     visuHeightEditor.setText(std::to_string(processor.getVisualizationHeight()), false);
-}
\ No newline at end of file
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::updateBuffers()
+{
+    juce::StringArray names;
+    for (int i = 0; i < processor.getNumBuffers(); i++) {
+        names.add(processor.getBufferName(i));
+    }
+
+    numBuffersEditor.setText(std::to_string(processor.getNumBuffers()), false);
+    bufferNamesEditor.setText(names.joinIntoString(", "), false);
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::updateDynamicResolution()
+{
+    dynamicResolutionButton.setToggleState(processor.getDynamicResolution(),
+                                           juce::NotificationType::dontSendNotification);
+    targetFpsEditor.setText(std::to_string(processor.getTargetFps()), false);
+    minScaleEditor.setText(std::to_string(processor.getMinResolutionScale()), false);
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::updateFramePacing()
+{
+    frameRateLimitEditor.setText(std::to_string(processor.getFrameRateLimit()), false);
+    framesInFlightEditor.setText(std::to_string(processor.getMaxFramesInFlight()), false);
+}
+
+void
+PatchEditor::GlobalPropertiesComponent::updateExport()
+{
+    exportFpsEditor.setText(std::to_string(processor.getExportFps()), false);
+    exportFormatBox.setSelectedId(processor.getExportFormat(),
+                                  juce::NotificationType::dontSendNotification);
+}
@@ -127,6 +127,7 @@ private:
         void activateFixedSizeEditors();
         void greyOut();
         void load(int shaderIdx);
+        void updateDestinations();
 
     private:
         juce::Label shaderPropertiesLabel;
@@ -137,6 +138,19 @@ private:
         juce::Label fixedSizeHeightLabel;
         juce::ComboBox destinationBox;
         juce::Label destinationLabel;
+        juce::ComboBox formatBox;
+        juce::Label formatLabel;
+        juce::ComboBox filterBox;
+        juce::Label filterLabel;
+        juce::ComboBox wrapBox;
+        juce::Label wrapLabel;
+        juce::ToggleButton mipmapsButton;
+        juce::ComboBox targetsBox;
+        juce::Label targetsLabel;
+        juce::TextEditor updateDivisorEditor;
+        juce::Label updateDivisorLabel;
+        juce::TextEditor updateHzEditor;
+        juce::Label updateHzLabel;
 
         ShadertoyAudioProcessorEditor &editor;
         ShadertoyAudioProcessor &processor;
@@ -145,7 +159,10 @@ private:
     };
 
     class GlobalPropertiesComponent : public juce::Component,
-                                      public juce::TextEditor::Listener
+                                      public juce::Button::Listener,
+                                      public juce::TextEditor::Listener,
+                                      public juce::ComboBox::Listener,
+                                      private juce::Timer
     {
     public:
         GlobalPropertiesComponent(ShadertoyAudioProcessorEditor &editor,
@@ -154,16 +171,56 @@ private:
 
         void paint(juce::Graphics&) override;
         void resized() override;
+        void buttonClicked(juce::Button *) override;
         void textEditorTextChanged(juce::TextEditor &) override;
+        void textEditorReturnKeyPressed(juce::TextEditor &) override;
+        void textEditorFocusLost(juce::TextEditor &) override;
+        void comboBoxChanged(juce::ComboBox *comboBoxThatHasChanged) override;
 
         void updateVisuSize();
+        void updateBuffers();
+        void updateDynamicResolution();
+        void updateFramePacing();
+        void updateExport();
 
     private:
+        void applyNumBuffers();
+        void applyBufferNames();
+        bool chooseExportDestination(juce::File &destination);
+        void startExport(const juce::File &inputFile, bool isCapture);
+        void toggleRecording();
+        void timerCallback() override;
+
         juce::Label globalPropertiesLabel;
         juce::TextEditor visuWidthEditor;
         juce::Label visuWidthLabel;
         juce::TextEditor visuHeightEditor;
         juce::Label visuHeightLabel;
+        juce::TextEditor numBuffersEditor;
+        juce::Label numBuffersLabel;
+        juce::TextEditor bufferNamesEditor;
+        juce::Label bufferNamesLabel;
+        juce::ToggleButton dynamicResolutionButton;
+        juce::TextEditor targetFpsEditor;
+        juce::Label targetFpsLabel;
+        juce::TextEditor minScaleEditor;
+        juce::Label minScaleLabel;
+        juce::TextEditor frameRateLimitEditor;
+        juce::Label frameRateLimitLabel;
+        juce::TextEditor framesInFlightEditor;
+        juce::Label framesInFlightLabel;
+        juce::TextEditor exportFpsEditor;
+        juce::Label exportFpsLabel;
+        juce::ComboBox exportFormatBox;
+        juce::Label exportFormatLabel;
+        juce::TextButton exportBounceButton;
+        juce::TextButton exportFileButton;
+        juce::TextButton exportStopButton;
+        juce::Label exportStatusLabel;
+        juce::TextButton captureRecordButton;
+        juce::TextButton captureReplayButton;
+        juce::ToggleButton captureRealTimeButton;
+        juce::Label captureStatusLabel;
 
         ShadertoyAudioProcessorEditor &editor;
         ShadertoyAudioProcessor &processor;
@@ -10,6 +10,8 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "OfflineExporter.h"
+#include "InputRecorder.h"
 
 //==============================================================================
 ShadertoyAudioProcessor::ShadertoyAudioProcessor()
@@ -26,17 +28,23 @@ ShadertoyAudioProcessor::ShadertoyAudioProcessor()
 #endif
     editor(nullptr)
 {
+    for (auto &slot : audioListeners) {
+        slot = nullptr;
+    }
+
     outputProgramParam = std::move(std::unique_ptr<juce::AudioParameterInt>
         (new juce::AudioParameterInt("program_output", "program_output", 0, 100, 0)));
     addParameter(outputProgramParam.get());
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < NUM_BUFFER_PARAMS; i++) {
         juce::String name = "program_buffer";
         name += char('A' + i);
         bufferProgramParams.emplace_back(new juce::AudioParameterInt(name, name, 0, 100, 0));
         addParameter(bufferProgramParams.back().get());
     }
 
+    setNumBuffers(DEFAULT_NUM_BUFFERS);
+
     for (int i = 0; i < 256; i++) {
         addUniformFloat("float" + std::to_string(i));
     }
@@ -44,10 +52,15 @@ ShadertoyAudioProcessor::ShadertoyAudioProcessor()
     for (int i = 0; i < 256; i++) {
         addUniformInt("int" + std::to_string(i));
     }
+
+    offlineExporter.reset(new OfflineExporter(*this));
+    inputRecorder.reset(new InputRecorder(*this));
 }
 
 ShadertoyAudioProcessor::~ShadertoyAudioProcessor()
 {
+    inputRecorder.reset();
+    offlineExporter.reset();
 }
 
 //==============================================================================
@@ -119,13 +132,14 @@ void ShadertoyAudioProcessor::changeProgramName(int index, const juce::String& n
 //==============================================================================
 void ShadertoyAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    (void)(samplesPerBlock);
-
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     mSampleRate = sampleRate;
+    mPreparedSampleRate = sampleRate;
+    mPreparedBlockSize = samplesPerBlock;
     if (editor) {
-        editor->logDebugMessage("prepareToPlay: sample rate " + std::to_string(mSampleRate));
+        editor->logDebugMessage("prepareToPlay: sample rate " + std::to_string(mSampleRate) +
+                                ", block size " + std::to_string(samplesPerBlock));
     }
 }
 
@@ -163,13 +177,47 @@ void ShadertoyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juc
 {
     juce::ScopedNoDenormals noDenormals;
 
-    for (auto listener : audioListeners) {
-        listener->handleAudioFrame(mTimestamp, mSampleRate, buffer, midiMessages);
+    dispatchingAudio = true;
+    for (auto &slot : audioListeners) {
+        AudioListener *listener = slot.load();
+        if (listener != nullptr) {
+            listener->handleAudioFrame(mTimestamp, mSampleRate, buffer, midiMessages);
+        }
     }
+    dispatchingAudio = false;
 
     mTimestamp += (double)(buffer.getNumSamples()) / mSampleRate;
 }
 
+void ShadertoyAudioProcessor::addAudioListener(AudioListener *listener)
+{
+    for (auto &slot : audioListeners) {
+        AudioListener *expected = nullptr;
+        if (slot.compare_exchange_strong(expected, listener)) {
+            return;
+        }
+    }
+
+    jassertfalse; // Out of listener slots
+}
+
+void ShadertoyAudioProcessor::removeAudioListener(AudioListener *listener)
+{
+    for (auto &slot : audioListeners) {
+        AudioListener *expected = listener;
+        slot.compare_exchange_strong(expected, nullptr);
+    }
+
+    /*
+     * The audio thread may have picked up the listener just before it was
+     * cleared. Wait for the current dispatch to finish; the audio thread
+     * itself never waits on us.
+     */
+    while (dispatchingAudio.load()) {
+        juce::Thread::yield();
+    }
+}
+
 //==============================================================================
 bool ShadertoyAudioProcessor::hasEditor() const
 {
@@ -203,6 +251,19 @@ void ShadertoyAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
             fixedSizeData->setAttribute("Height", shaderData[i].fixedSizeHeight);
             shaderFileElement->addChildElement(fixedSizeData);
         }
+
+        juce::XmlElement *textureData = new juce::XmlElement("Texture");
+        textureData->setAttribute("Format", shaderData[i].texture.format);
+        textureData->setAttribute("Filter", shaderData[i].texture.filter);
+        textureData->setAttribute("Wrap", shaderData[i].texture.wrap);
+        textureData->setAttribute("Mipmaps", shaderData[i].texture.mipmaps);
+        textureData->setAttribute("Targets", shaderData[i].texture.numTargets);
+        shaderFileElement->addChildElement(textureData);
+
+        juce::XmlElement *updateData = new juce::XmlElement("Update");
+        updateData->setAttribute("Divisor", shaderData[i].updateDivisor);
+        updateData->setAttribute("Hz", shaderData[i].updateHz);
+        shaderFileElement->addChildElement(updateData);
         
         xml.addChildElement(shaderFileElement);
     }
@@ -210,13 +271,32 @@ void ShadertoyAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
     juce::XmlElement *globalProperties = new juce::XmlElement("GlobalProperties");
     globalProperties->setAttribute("Width", visualizationWidth);
     globalProperties->setAttribute("Height", visualizationHeight);
+    globalProperties->setAttribute("DynamicResolution", dynamicResolution);
+    globalProperties->setAttribute("TargetFps", targetFps);
+    globalProperties->setAttribute("MinResolutionScale", minResolutionScale);
+    globalProperties->setAttribute("FrameRateLimit", frameRateLimit);
+    globalProperties->setAttribute("MaxFramesInFlight", maxFramesInFlight);
+    globalProperties->setAttribute("ExportFps", exportFps);
+    globalProperties->setAttribute("ExportFormat", exportFormat);
     xml.addChildElement(globalProperties);
+
+    juce::XmlElement *buffers = new juce::XmlElement("Buffers");
+    const juce::ScopedLock lock(bufferNamesLock);
+    for (auto &name : bufferNames) {
+        juce::XmlElement *buffer = new juce::XmlElement("Buffer");
+        buffer->setAttribute("Name", name);
+        buffers->addChildElement(buffer);
+    }
+    xml.addChildElement(buffers);
     copyXmlToBinary(xml, destData);
 }
 
 void ShadertoyAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
     shaderData.clear();
+    setBufferNames(juce::StringArray());
+    setNumBuffers(DEFAULT_NUM_BUFFERS); // Patches from before named buffers
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState.get() != nullptr && xmlState->hasTagName("ShadertoyState")) {
         juce::XmlElement* child = xmlState->getFirstChildElement();
@@ -236,17 +316,50 @@ void ShadertoyAudioProcessor::setStateInformation(const void* data, int sizeInBy
                             shaderChild->getIntAttribute("Width", shaderData.back().fixedSizeWidth);
                         shaderData.back().fixedSizeHeight =
                             shaderChild->getIntAttribute("Height", shaderData.back().fixedSizeHeight);
+                    } else if (shaderChild->hasTagName("Texture")) {
+                        BufferTexture &texture = shaderData.back().texture;
+                        texture.format = juce::jlimit((int)FORMAT_RGBA8, (int)FORMAT_RGB8,
+                            shaderChild->getIntAttribute("Format", texture.format));
+                        texture.filter = juce::jlimit((int)FILTER_NEAREST, (int)FILTER_LINEAR,
+                            shaderChild->getIntAttribute("Filter", texture.filter));
+                        texture.wrap = juce::jlimit((int)WRAP_CLAMP, (int)WRAP_MIRROR,
+                            shaderChild->getIntAttribute("Wrap", texture.wrap));
+                        texture.mipmaps = shaderChild->getBoolAttribute("Mipmaps", texture.mipmaps);
+                        texture.numTargets = juce::jlimit(1, MAX_RENDER_TARGETS,
+                            shaderChild->getIntAttribute("Targets", texture.numTargets));
+                    } else if (shaderChild->hasTagName("Update")) {
+                        setShaderUpdateDivisor((int)(getNumShaderFiles() - 1),
+                            shaderChild->getIntAttribute("Divisor", shaderData.back().updateDivisor));
+                        setShaderUpdateHz((int)(getNumShaderFiles() - 1),
+                            shaderChild->getDoubleAttribute("Hz", shaderData.back().updateHz));
                     }
                     shaderChild = shaderChild->getNextElement();
                 }
             } else if (child->hasTagName("GlobalProperties")) {
                 visualizationWidth = child->getIntAttribute("Width", visualizationWidth);
                 visualizationHeight = child->getIntAttribute("Height", visualizationHeight);
+                dynamicResolution = child->getBoolAttribute("DynamicResolution", dynamicResolution);
+                targetFps = child->getIntAttribute("TargetFps", targetFps);
+                minResolutionScale = child->getIntAttribute("MinResolutionScale", minResolutionScale);
+                setFrameRateLimit(child->getIntAttribute("FrameRateLimit", frameRateLimit));
+                setMaxFramesInFlight(child->getIntAttribute("MaxFramesInFlight", maxFramesInFlight));
+                setExportFps(child->getIntAttribute("ExportFps", exportFps));
+                setExportFormat(juce::jlimit((int)FrameWriter::FORMAT_PNG_SEQUENCE,
+                                             (int)FrameWriter::FORMAT_DISCARD,
+                                             child->getIntAttribute("ExportFormat", exportFormat)));
+            } else if (child->hasTagName("Buffers")) {
+                juce::StringArray names;
+                for (int i = 0; i < child->getNumChildElements(); i++) {
+                    names.add(child->getChildElement(i)->getStringAttribute("Name"));
+                }
+                setBufferNames(names);
             }
             child = child->getNextElement();
         }
     }
 
+    updateWatchedShaderFiles();
+
     for (auto *listener : stateListeners) {
         listener->processorStateChanged();
     }
@@ -286,7 +399,142 @@ int ShadertoyAudioProcessor::getOutputProgramIdx()
 
 int ShadertoyAudioProcessor::getBufferProgramIdx(int bufferId)
 {
-    return bufferProgramParams[bufferId]->get();
+    if (bufferId < NUM_BUFFER_PARAMS) {
+        return bufferProgramParams[bufferId]->get();
+    }
+
+    for (int i = 0; i < shaderData.size(); i++) {
+        if (shaderData[i].destination == 2 + bufferId) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+float ShadertoyAudioProcessor::getSnapshotValue(const juce::RangedAudioParameter &param,
+                                                const std::vector<float> &snapshot)
+{
+    // Parameters added after the capture was made keep their live value
+    int idx = param.getParameterIndex();
+    float value = idx >= 0 && idx < (int)snapshot.size() ? snapshot[idx] : param.getValue();
+    return param.convertFrom0to1(value);
+}
+
+float ShadertoyAudioProcessor::getUniformFloat(int i, const std::vector<float> &snapshot)
+{
+    return getSnapshotValue(*floatParams[i], snapshot);
+}
+
+int ShadertoyAudioProcessor::getUniformInt(int i, const std::vector<float> &snapshot)
+{
+    return juce::roundToInt(getSnapshotValue(*intParams[i], snapshot));
+}
+
+int ShadertoyAudioProcessor::getOutputProgramIdx(const std::vector<float> &snapshot)
+{
+    return juce::roundToInt(getSnapshotValue(*outputProgramParam, snapshot));
+}
+
+int ShadertoyAudioProcessor::getBufferProgramIdx(int bufferId, const std::vector<float> &snapshot)
+{
+    if (bufferId < NUM_BUFFER_PARAMS) {
+        return juce::roundToInt(getSnapshotValue(*bufferProgramParams[bufferId], snapshot));
+    }
+
+    return getBufferProgramIdx(bufferId);
+}
+
+void ShadertoyAudioProcessor::setNumBuffers(int numBuffers)
+{
+    numBuffers = juce::jlimit(0, MAX_BUFFERS, numBuffers);
+
+    const juce::ScopedLock lock(bufferNamesLock);
+    bufferNames.resize(juce::jmin((int)bufferNames.size(), numBuffers));
+    while ((int)bufferNames.size() < numBuffers) {
+        bufferNames.push_back(makeDefaultBufferName((int)bufferNames.size()));
+    }
+}
+
+/*
+ * Names that aren't GLSL identifier characters, or that would make
+ * iBuffer<Name> ambiguous, are replaced with a default.
+ */
+void ShadertoyAudioProcessor::setBufferName(int bufferId, const juce::String &name)
+{
+    const juce::ScopedLock lock(bufferNamesLock);
+    bufferNames[bufferId] = isValidBufferName(name, bufferId) ? name
+                                                              : makeDefaultBufferName(bufferId);
+}
+
+/*
+ * Replaces every buffer at once, so names can be swapped or shuffled
+ * without colliding with the old set.
+ */
+void ShadertoyAudioProcessor::setBufferNames(const juce::StringArray &names)
+{
+    int numBuffers = juce::jlimit(0, MAX_BUFFERS, names.size());
+
+    // Readers never see the half-assigned list
+    const juce::ScopedLock lock(bufferNamesLock);
+    bufferNames.assign(numBuffers, juce::String());
+    for (int i = 0; i < numBuffers; i++) {
+        setBufferName(i, names[i].trim());
+    }
+}
+
+bool ShadertoyAudioProcessor::isValidBufferName(const juce::String &name, int bufferId)
+{
+    if (name.isEmpty() ||
+        !name.containsOnly("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_")) {
+        return false;
+    }
+
+    for (int i = 0; i < bufferNames.size(); i++) {
+        if (i != bufferId && bufferNames[i] == name) {
+            return false;
+        }
+    }
+
+    // Don't shadow another buffer's A..D alias
+    for (int i = 0; i < juce::jmin(NUM_BUFFER_PARAMS, (int)bufferNames.size()); i++) {
+        if (i != bufferId && name == juce::String::charToString('A' + i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+juce::String ShadertoyAudioProcessor::makeDefaultBufferName(int bufferId)
+{
+    juce::String name = juce::String::charToString('A' + bufferId);
+    for (int suffix = 1; !isValidBufferName(name, bufferId); suffix++) {
+        name = juce::String::charToString('A' + bufferId) + juce::String(suffix);
+    }
+    return name;
+}
+
+/*
+ * Resolves the <Name> part of iBuffer<Name> / iResolutionBuffer<Name>
+ * to a buffer index, or -1.
+ */
+int ShadertoyAudioProcessor::findBuffer(const juce::String &name)
+{
+    const juce::ScopedLock lock(bufferNamesLock);
+    for (int i = 0; i < bufferNames.size(); i++) {
+        if (bufferNames[i] == name) {
+            return i;
+        }
+    }
+
+    for (int i = 0; i < juce::jmin(NUM_BUFFER_PARAMS, (int)bufferNames.size()); i++) {
+        if (name == juce::String::charToString('A' + i)) {
+            return i;
+        }
+    }
+
+    return -1;
 }
 
 void ShadertoyAudioProcessor::addShaderFileEntry()
@@ -297,12 +545,14 @@ void ShadertoyAudioProcessor::addShaderFileEntry()
 void ShadertoyAudioProcessor::removeShaderFileEntry(int idx)
 {
     shaderData.erase(shaderData.begin() + idx);
+    updateWatchedShaderFiles();
 }
 
 void ShadertoyAudioProcessor::setShaderFile(int idx, juce::String shaderFile)
 {
     shaderData[idx].path = std::move(shaderFile);
     reloadShaderFile(idx);
+    updateWatchedShaderFiles();
 }
 
 void ShadertoyAudioProcessor::setShaderFixedSizeBuffer(int idx, bool fixedSizeBuffer)
@@ -325,10 +575,74 @@ void ShadertoyAudioProcessor::setShaderDestination(int idx, int destination)
     shaderData[idx].destination = destination;
 }
 
+void ShadertoyAudioProcessor::setShaderTexture(int idx, const BufferTexture &texture)
+{
+    shaderData[idx].texture = texture;
+}
+
+void ShadertoyAudioProcessor::setShaderUpdateDivisor(int idx, int divisor)
+{
+    shaderData[idx].updateDivisor = juce::jlimit(1, MAX_UPDATE_DIVISOR, divisor);
+}
+
+void ShadertoyAudioProcessor::setShaderUpdateHz(int idx, double hz)
+{
+    shaderData[idx].updateHz = juce::jmax(0.0, hz);
+}
+
+void ShadertoyAudioProcessor::setFrameRateLimit(int fps)
+{
+    frameRateLimit = juce::jlimit(0, MAX_FRAME_RATE_LIMIT, fps);
+
+    for (auto *listener : stateListeners) {
+        listener->framePacingChanged();
+    }
+}
+
+void ShadertoyAudioProcessor::setMaxFramesInFlight(int frames)
+{
+    maxFramesInFlight = juce::jlimit(1, MAX_FRAMES_IN_FLIGHT, frames);
+
+    for (auto *listener : stateListeners) {
+        listener->framePacingChanged();
+    }
+}
+
 void ShadertoyAudioProcessor::reloadShaderFile(int idx)
 {
     juce::File file(shaderData[idx].path);
     shaderData[idx].source = file.loadFileAsString();
+
+    for (auto *listener : stateListeners) {
+        listener->shaderReloaded(idx);
+    }
+}
+
+void ShadertoyAudioProcessor::updateWatchedShaderFiles()
+{
+    juce::StringArray paths;
+    for (auto &shader : shaderData) {
+        paths.add(shader.path);
+    }
+
+    // The host may restore state off the message thread, and the watcher
+    // is message thread only. Always posting keeps the updates in order.
+    juce::WeakReference<ShaderFileWatcher> watcher(&shaderFileWatcher);
+    juce::MessageManager::callAsync([watcher, paths]() {
+        if (watcher != nullptr) {
+            watcher->setFiles(paths);
+        }
+    });
+}
+
+void ShadertoyAudioProcessor::shaderFileChanged(const juce::String &path)
+{
+    for (int i = 0; i < shaderData.size(); i++) {
+        if (juce::File::isAbsolutePath(shaderData[i].path) &&
+            juce::File(shaderData[i].path) == juce::File(path)) {
+            reloadShaderFile(i);
+        }
+    }
 }
 
 const juce::String &ShadertoyAudioProcessor::getShaderFile(int idx)
@@ -361,6 +675,21 @@ int ShadertoyAudioProcessor::getShaderDestination(int idx)
     return shaderData[idx].destination;
 }
 
+const ShadertoyAudioProcessor::BufferTexture &ShadertoyAudioProcessor::getShaderTexture(int idx)
+{
+    return shaderData[idx].texture;
+}
+
+int ShadertoyAudioProcessor::getShaderUpdateDivisor(int idx)
+{
+    return shaderData[idx].updateDivisor;
+}
+
+double ShadertoyAudioProcessor::getShaderUpdateHz(int idx)
+{
+    return shaderData[idx].updateHz;
+}
+
 size_t ShadertoyAudioProcessor::getNumShaderFiles()
 {
     return shaderData.size();
@@ -11,21 +11,38 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <atomic>
+#include "ShaderFileWatcher.h"
+#include "FrameWriter.h"
 
 class ShadertoyAudioProcessorEditor;
+class OfflineExporter;
+class InputRecorder;
 
 /*
  * ShadertoyAudioProcessor
  *    The audio processor. This is responsible for saving / loading patches
  *    and directing audio / midi / parameter input to the visualization.
  */
-class ShadertoyAudioProcessor  : public juce::AudioProcessor
+class ShadertoyAudioProcessor  : public juce::AudioProcessor,
+                                 private ShaderFileWatcher::Listener
 {
 public:
     class StateListener
     {
     public:
         virtual void processorStateChanged() = 0;
+
+        /*
+         * The source of shader idx was re-read from disk, either on
+         * request or because the file changed.
+         */
+        virtual void shaderReloaded(int idx) { (void)(idx); }
+
+        /*
+         * The frame rate limit or frames-in-flight limit changed.
+         */
+        virtual void framePacingChanged() { }
     };
 
     class AudioListener
@@ -73,6 +90,93 @@ public:
     int getOutputProgramIdx();
     int getBufferProgramIdx(int bufferId);
 
+    /*
+     * The same values taken from a snapshot of normalised parameter
+     * values in getParameters() order, as replayed from a capture (see
+     * CaptureReader), rather than from the live parameters.
+     */
+    float getUniformFloat(int i, const std::vector<float> &snapshot);
+    int getUniformInt(int i, const std::vector<float> &snapshot);
+    int getOutputProgramIdx(const std::vector<float> &snapshot);
+    int getBufferProgramIdx(int bufferId, const std::vector<float> &snapshot);
+
+    /*
+     * Auxiliary buffers. Buffer k is destination 2 + k and is sampled as
+     * iBuffer<Name>. The first four are also reachable as iBufferA..D
+     * whatever they are named, and are the only ones with a
+     * program_buffer* parameter; the others are rendered by the first
+     * shader targeting them.
+     *
+     * The render thread resolves names during shader reflection while
+     * the editor may be renaming, so names are guarded by a lock and
+     * returned by value.
+     */
+    int getNumBuffers()
+      { const juce::ScopedLock lock(bufferNamesLock); return (int)bufferNames.size(); }
+    void setNumBuffers(int numBuffers);
+    juce::String getBufferName(int bufferId)
+      { const juce::ScopedLock lock(bufferNamesLock); return bufferNames[bufferId]; }
+    void setBufferName(int bufferId, const juce::String &name);
+    void setBufferNames(const juce::StringArray &names);
+    int findBuffer(const juce::String &name);
+
+    static constexpr int MAX_BUFFERS = 26;
+    static constexpr int NUM_BUFFER_PARAMS = 4;
+    static constexpr int DEFAULT_NUM_BUFFERS = 4;
+
+    /*
+     * The sample rate / block size last given to prepareToPlay. Audio
+     * listeners size their realtime buffers from these.
+     */
+    double getPreparedSampleRate()
+      { return mPreparedSampleRate.load(); }
+    int getPreparedBlockSize()
+      { return mPreparedBlockSize.load(); }
+
+    /*
+     * Storage of the framebuffer a shader renders to. Enumerators start
+     * at 1 so they double as combo box ids, and new ones go at the end
+     * so saved patches keep their meaning. RGB8 is the default, as
+     * buffers were before formats could be chosen: alpha always reads
+     * back as 1.
+     */
+    enum BufferFormat {
+        FORMAT_RGBA8 = 1,
+        FORMAT_R8,
+        FORMAT_R16F,
+        FORMAT_RGBA16F,
+        FORMAT_R32F,
+        FORMAT_RGBA32F,
+        FORMAT_RGB8
+    };
+
+    enum BufferFilter {
+        FILTER_NEAREST = 1,
+        FILTER_LINEAR
+    };
+
+    /*
+     * Repeat is the default, as buffers were sampled before wrapping
+     * could be chosen.
+     */
+    enum BufferWrap {
+        WRAP_CLAMP = 1,
+        WRAP_REPEAT,
+        WRAP_MIRROR
+    };
+
+    struct BufferTexture
+    {
+        int format = FORMAT_RGB8;
+        int filter = FILTER_NEAREST;
+        int wrap = WRAP_REPEAT;
+        bool mipmaps = false;
+        int numTargets = 1; // Color attachments, aux buffers only
+    };
+
+    static constexpr int MAX_RENDER_TARGETS = 4;
+    static constexpr int MAX_UPDATE_DIVISOR = 240;
+
     int getVisualizationWidth()
       { return visualizationWidth; }
     void setVisualizationWidth(int width)
@@ -81,6 +185,62 @@ public:
       { return visualizationHeight; }
     void setVisualizationHeight(int height)
       { visualizationHeight = height; }
+
+    /*
+     * Dynamic resolution: when enabled, the renderer lowers the render
+     * resolution of expensive passes (down to minResolutionScale percent
+     * of their normal size) to hold the target frame rate.
+     */
+    bool getDynamicResolution()
+      { return dynamicResolution; }
+    void setDynamicResolution(bool enabled)
+      { dynamicResolution = enabled; }
+    int getTargetFps()
+      { return targetFps; }
+    void setTargetFps(int fps)
+      { targetFps = fps; }
+    int getMinResolutionScale()
+      { return minResolutionScale; }
+    void setMinResolutionScale(int percent)
+      { minResolutionScale = percent; }
+
+    /*
+     * Frame pacing: the renderer starts at most frameRateLimit frames per
+     * second (0 follows the display), and never has more than
+     * maxFramesInFlight frames queued on the GPU.
+     */
+    int getFrameRateLimit()
+      { return frameRateLimit; }
+    void setFrameRateLimit(int fps);
+    int getMaxFramesInFlight()
+      { return maxFramesInFlight; }
+    void setMaxFramesInFlight(int frames);
+
+    static constexpr int MAX_FRAME_RATE_LIMIT = 500;
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+
+    /*
+     * Offline export (see OfflineExporter). Frames are exported at the
+     * visualization size.
+     */
+    OfflineExporter &getOfflineExporter()
+      { return *offlineExporter; }
+    int getExportFps()
+      { return exportFps; }
+    void setExportFps(int fps)
+      { exportFps = juce::jlimit(1, MAX_EXPORT_FPS, fps); }
+    int getExportFormat()
+      { return exportFormat; }
+    void setExportFormat(int format)
+      { exportFormat = format; }
+
+    static constexpr int MAX_EXPORT_FPS = 240;
+
+    /*
+     * Input capture for deterministic replay (see InputRecorder).
+     */
+    InputRecorder &getInputRecorder()
+      { return *inputRecorder; }
     
     void addShaderFileEntry();
     void removeShaderFileEntry(int idx);
@@ -89,6 +249,9 @@ public:
     void setShaderFixedSizeWidth(int idx, int width);
     void setShaderFixedSizeHeight(int idx, int height);
     void setShaderDestination(int idx, int destination);
+    void setShaderTexture(int idx, const BufferTexture &texture);
+    void setShaderUpdateDivisor(int idx, int divisor);
+    void setShaderUpdateHz(int idx, double hz);
     void reloadShaderFile(int idx);
     const juce::String &getShaderFile(int idx);
     const juce::String &getShaderString(int idx);
@@ -96,6 +259,9 @@ public:
     int getShaderFixedSizeWidth(int idx);
     int getShaderFixedSizeHeight(int idx);
     int getShaderDestination(int idx);
+    const BufferTexture &getShaderTexture(int idx);
+    int getShaderUpdateDivisor(int idx);
+    double getShaderUpdateHz(int idx);
     size_t getNumShaderFiles();
     bool hasShaderFiles();
 
@@ -112,18 +278,12 @@ public:
       }
     }
 
-    void addAudioListener(AudioListener *listener)
-    {
-      audioListeners.emplace_back(listener);
-    }
-
-    void removeAudioListener(AudioListener *listener)
-    {
-      auto it = std::find(audioListeners.begin(), audioListeners.end(), listener);
-      if (it != audioListeners.end()) {
-        audioListeners.erase(it);
-      }
-    }
+    /*
+     * Once removeAudioListener returns, the listener is guaranteed not to
+     * be inside handleAudioFrame.
+     */
+    void addAudioListener(AudioListener *listener);
+    void removeAudioListener(AudioListener *listener);
 
     void editorFreed() { this->editor = nullptr; }
 
@@ -136,25 +296,60 @@ private:
         int fixedSizeWidth = 640;
         int fixedSizeHeight = 360;
         int destination = 1;
+        BufferTexture texture;
+        int updateDivisor = 1;   // Render every N frames
+        double updateHz = 0.0;   // If > 0, render at this rate instead
     };
 
     void addUniformFloat(const juce::String &name);
     void addUniformInt(const juce::String &name);
+    void updateWatchedShaderFiles();
+    bool isValidBufferName(const juce::String &name, int bufferId);
+    juce::String makeDefaultBufferName(int bufferId);
+    void shaderFileChanged(const juce::String &path) override;
+    float getSnapshotValue(const juce::RangedAudioParameter &param,
+                           const std::vector<float> &snapshot);
 
     ShadertoyAudioProcessorEditor *editor;
 
+    /*
+     * Audio listeners are read on the audio thread, so they live in a
+     * fixed set of slots instead of a container that can reallocate.
+     */
+    static constexpr int MAX_AUDIO_LISTENERS = 8;
+
     std::vector<StateListener *> stateListeners;
-    std::vector<AudioListener *> audioListeners;
+    std::atomic<AudioListener *> audioListeners[MAX_AUDIO_LISTENERS];
+    std::atomic<bool> dispatchingAudio { false };
 
     std::vector<std::unique_ptr<juce::AudioParameterFloat>> floatParams;
     std::vector<std::unique_ptr<juce::AudioParameterInt>> intParams;
     std::unique_ptr<juce::AudioParameterInt> outputProgramParam;
     std::vector<std::unique_ptr<juce::AudioParameterInt>> bufferProgramParams;
+    std::vector<juce::String> bufferNames;
+    juce::CriticalSection bufferNamesLock;
     std::vector<ShaderData> shaderData;
+    ShaderFileWatcher shaderFileWatcher { *this };
     int visualizationWidth = 1280;
     int visualizationHeight = 720;
+    bool dynamicResolution = false;
+    int targetFps = 60;
+    int minResolutionScale = 50;
+    int frameRateLimit = 0;
+    int maxFramesInFlight = MAX_FRAMES_IN_FLIGHT;
+    int exportFps = 60;
+    int exportFormat = FrameWriter::FORMAT_PNG_SEQUENCE;
     double mTimestamp = 0.0;
     double mSampleRate = 44100.0;
+    std::atomic<double> mPreparedSampleRate { 44100.0 };
+    std::atomic<int> mPreparedBlockSize { 512 };
+
+    /*
+     * Declared last so they are destroyed first, while the listener
+     * slots they unregister from are still around.
+     */
+    std::unique_ptr<OfflineExporter> offlineExporter;
+    std::unique_ptr<InputRecorder> inputRecorder;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ShadertoyAudioProcessor)
 };
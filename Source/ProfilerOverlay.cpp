@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    ProfilerOverlay.cpp
+    Created: 16 Oct 2026 9:41:18pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ProfilerOverlay.h"
+
+ProfilerOverlay::ProfilerOverlay(const FrameProfiler &profiler) // IN
+ : profiler(profiler)
+{
+    // Only the buttons take clicks, the rest is see-through
+    setInterceptsMouseClicks(false, true);
+
+    addAndMakeVisible(toggleButton);
+    toggleButton.setButtonText("Profiler");
+    toggleButton.setClickingTogglesState(true);
+    toggleButton.addListener(this);
+
+    addChildComponent(exportButton);
+    exportButton.setButtonText("Export CSV");
+    exportButton.addListener(this);
+}
+
+ProfilerOverlay::~ProfilerOverlay()
+{
+    stopTimer();
+}
+
+void
+ProfilerOverlay::paint(juce::Graphics &g) // IN / OUT
+{
+    if (!toggleButton.getToggleState()) {
+        return;
+    }
+
+    int panelHeight = MARGIN * 3 + BUTTON_HEIGHT + ROW_HEIGHT * juce::jmax(1, (int)rows.size());
+    juce::Rectangle<int> panel(MARGIN, MARGIN, PANEL_WIDTH, panelHeight);
+
+    g.setColour(juce::Colour(0xb0000000));
+    g.fillRoundedRectangle(panel.toFloat(), 4.0f);
+
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain));
+    g.setColour(juce::Colours::white);
+
+    juce::Rectangle<int> area = panel.reduced(MARGIN);
+    area.removeFromTop(BUTTON_HEIGHT + MARGIN);
+
+    if (rows.empty()) {
+        g.drawText("No frames yet", area.removeFromTop(ROW_HEIGHT),
+                   juce::Justification::centredLeft);
+    }
+
+    for (auto &row : rows) {
+        juce::Rectangle<int> line = area.removeFromTop(ROW_HEIGHT);
+        g.drawText(row.name, line, juce::Justification::centredLeft);
+        g.drawText(row.ms >= 0.0f ? juce::String(row.ms, 3) + " ms" : juce::String("n/a"),
+                   line, juce::Justification::centredRight);
+    }
+}
+
+void
+ProfilerOverlay::resized()
+{
+    toggleButton.setBounds(MARGIN * 2, MARGIN * 2, BUTTON_WIDTH, BUTTON_HEIGHT);
+    exportButton.setBounds(MARGIN * 3 + BUTTON_WIDTH, MARGIN * 2, BUTTON_WIDTH, BUTTON_HEIGHT);
+}
+
+void
+ProfilerOverlay::buttonClicked(juce::Button *button) // IN
+{
+    if (button == &toggleButton) {
+        bool shown = toggleButton.getToggleState();
+        exportButton.setVisible(shown);
+
+        if (shown) {
+            timerCallback();
+            startTimerHz(REFRESH_HZ);
+        } else {
+            stopTimer();
+            rows.clear();
+        }
+
+        repaint();
+    } else if (button == &exportButton) {
+        exportCsv();
+    }
+}
+
+/*
+ * ProfilerOverlay::timerCallback
+ *    Rebuilds the rows from the latest frames. GPU averages only count
+ *    frames in which the pass was actually rendered and timed, so passes
+ *    with an update divisor don't read as artificially cheap.
+ */
+void
+ProfilerOverlay::timerCallback()
+{
+    profiler.getSnapshot(snapshot, AVERAGE_FRAMES);
+
+    rows.clear();
+    if (snapshot.empty()) {
+        repaint();
+        return;
+    }
+
+    float cpuSum = 0.0f;
+    float uniformSum = 0.0f;
+    for (auto &frame : snapshot) {
+        cpuSum += frame.cpuMs;
+        uniformSum += frame.uniformMs;
+    }
+
+    rows.push_back({ "CPU frame", cpuSum / snapshot.size() });
+    rows.push_back({ "Uniform upload", uniformSum / snapshot.size() });
+
+    float gpuTotal = 0.0f;
+    bool anyGpu = false;
+    for (int i = 0; i < PassTimer::MAX_PASSES; i++) {
+        float sum = 0.0f;
+        int count = 0;
+        for (auto &frame : snapshot) {
+            if (frame.gpuMs[i] >= 0.0f) {
+                sum += frame.gpuMs[i];
+                count++;
+            }
+        }
+
+        if (count > 0) {
+            rows.push_back({ "GPU " + findPassName(i), sum / count });
+            gpuTotal += sum / count;
+            anyGpu = true;
+        }
+    }
+
+    rows.push_back({ "GPU total", anyGpu ? gpuTotal : -1.0f });
+    repaint();
+}
+
+juce::String
+ProfilerOverlay::findPassName(int passId) // IN
+{
+    return getPassName != nullptr ? getPassName(passId) : juce::String(passId);
+}
+
+void
+ProfilerOverlay::exportCsv()
+{
+    juce::FileChooser fileChooser("Export Profile",
+                                  juce::File::getSpecialLocation(juce::File::userHomeDirectory)
+                                      .getChildFile("profile.csv"),
+                                  "*.csv");
+    if (fileChooser.browseForFileToSave(true)) {
+        juce::StringArray passNames;
+        for (int i = 0; i < PassTimer::MAX_PASSES; i++) {
+            passNames.add(findPassName(i));
+        }
+
+        if (!profiler.exportCsv(fileChooser.getResult(), passNames)) {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                                   "Export failed",
+                                                   "Could not write " +
+                                                   fileChooser.getResult().getFullPathName());
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    ProfilerOverlay.h
+    Created: 16 Oct 2026 9:41:18pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FrameProfiler.h"
+
+/*
+ * ProfilerOverlay
+ *    Drawn on top of the visualization. A "Profiler" toggle shows a panel
+ *    with CPU frame time, uniform upload time and per-pass GPU time,
+ *    averaged over the last AVERAGE_FRAMES frames, and a button to export
+ *    the recorded history as CSV.
+ */
+class ProfilerOverlay : public juce::Component,
+                        public juce::Button::Listener,
+                        private juce::Timer
+{
+public:
+    ProfilerOverlay(const FrameProfiler &profiler);
+    ~ProfilerOverlay() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+    void buttonClicked(juce::Button *) override;
+
+    /*
+     * Name of a pass id, looked up whenever the rows are rebuilt or the
+     * history is exported.
+     */
+    std::function<juce::String (int passId)> getPassName;
+
+private:
+    void timerCallback() override;
+    void exportCsv();
+    juce::String findPassName(int passId);
+
+    struct Row {
+        juce::String name;
+        float ms;
+    };
+
+    const FrameProfiler &profiler;
+
+    juce::TextButton toggleButton;
+    juce::TextButton exportButton;
+
+    std::vector<FrameProfiler::Frame> snapshot;
+    std::vector<Row> rows;
+
+    static constexpr int AVERAGE_FRAMES = 30;
+    static constexpr int REFRESH_HZ = 4;
+    static constexpr int BUTTON_WIDTH = 75;
+    static constexpr int BUTTON_HEIGHT = 20;
+    static constexpr int ROW_HEIGHT = 16;
+    static constexpr int PANEL_WIDTH = 240;
+    static constexpr int MARGIN = 6;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProfilerOverlay)
+};
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    ProgramCache.cpp
+    Created: 16 Oct 2026 4:05:52pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ProgramCache.h"
+
+ProgramCache::ProgramCache()
+ : directory(getCacheDirectory())
+{
+}
+
+ProgramCache::~ProgramCache()
+{
+}
+
+void
+ProgramCache::setDriverId(const juce::String &id) // IN
+{
+    driverId = id;
+}
+
+/*
+ * ProgramCache::getCacheDirectory
+ *    $XDG_CACHE_HOME (or ~/.cache) on Linux, the per-user application
+ *    data directory elsewhere.
+ */
+juce::File
+ProgramCache::getCacheDirectory()
+{
+#if JUCE_LINUX
+    juce::String xdgCacheHome = juce::SystemStats::getEnvironmentVariable("XDG_CACHE_HOME", { });
+    juce::File base = juce::File::isAbsolutePath(xdgCacheHome)
+                    ? juce::File(xdgCacheHome)
+                    : juce::File("~/.cache");
+    return base.getChildFile("Shadertoy").getChildFile("programs");
+#else
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Shadertoy").getChildFile("ProgramCache");
+#endif
+}
+
+/*
+ * ProgramCache::makeKey
+ *    64-bit FNV-1a over the driver id and both sources. The pieces are
+ *    separated by a NUL so moving text between them changes the key.
+ */
+juce::uint64
+ProgramCache::makeKey(const char *vertexSource,         // IN
+                      const char *fragmentSource) const // IN
+{
+    juce::uint64 hash = 0xcbf29ce484222325ULL;
+    const char *parts[] = { driverId.toRawUTF8(), vertexSource, fragmentSource };
+
+    for (const char *part : parts) {
+        for (const char *c = part; ; c++) {
+            hash ^= (juce::uint8)*c;
+            hash *= 0x100000001b3ULL;
+            if (*c == '\0') {
+                break;
+            }
+        }
+    }
+
+    return hash;
+}
+
+juce::File
+ProgramCache::getFileForKey(juce::uint64 key) const // IN
+{
+    return directory.getChildFile(juce::String::toHexString((juce::int64)key)
+                                  .paddedLeft('0', 16) + ".bin");
+}
+
+bool
+ProgramCache::load(juce::uint64 key,               // IN
+                   GLenum &format,                 // OUT
+                   juce::MemoryBlock &binary) const // OUT
+{
+    juce::FileInputStream stream(getFileForKey(key));
+    FileHeader header;
+
+    if (!stream.openedOk() ||
+        stream.read(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != FILE_MAGIC ||
+        header.version != FILE_VERSION ||
+        header.size == 0 ||
+        (juce::int64)header.size != stream.getNumBytesRemaining()) {
+        return false;
+    }
+
+    binary.setSize(header.size);
+    if (stream.read(binary.getData(), (int)header.size) != (int)header.size) {
+        return false;
+    }
+
+    format = (GLenum)header.format;
+    return true;
+}
+
+/*
+ * ProgramCache::store
+ *    Writes through a temporary file so another instance reading the
+ *    same entry never sees it half written.
+ */
+void
+ProgramCache::store(juce::uint64 key,      // IN
+                    GLenum format,         // IN
+                    const void *binary,    // IN
+                    size_t size) const     // IN
+{
+    if (!directory.createDirectory()) {
+        return;
+    }
+
+    juce::File file = getFileForKey(key);
+    juce::TemporaryFile temp(file);
+    FileHeader header = { FILE_MAGIC, FILE_VERSION, (juce::uint32)format, (juce::uint32)size };
+
+    {
+        juce::FileOutputStream stream(temp.getFile());
+        if (!stream.openedOk() ||
+            !stream.write(&header, sizeof(header)) ||
+            !stream.write(binary, size)) {
+            return;
+        }
+    }
+
+    temp.overwriteTargetFileWithTemporary();
+}
+
+void
+ProgramCache::remove(juce::uint64 key) const // IN
+{
+    getFileForKey(key).deleteFile();
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    ProgramCache.h
+    Created: 16 Oct 2026 4:05:52pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ * ProgramCache
+ *    On-disk store of linked program binaries (glGetProgramBinary
+ *    output). Entries are keyed by a hash of the shader sources and the
+ *    driver identity, so editing a shader or updating the driver simply
+ *    misses the cache. Everything here is best effort: any failure just
+ *    means the program gets compiled from source.
+ */
+class ProgramCache
+{
+public:
+    ProgramCache();
+    ~ProgramCache();
+
+    /*
+     * Vendor / renderer / version of the current context. Binaries are
+     * only ever valid for the driver that produced them.
+     */
+    void setDriverId(const juce::String &driverId);
+
+    juce::uint64 makeKey(const char *vertexSource,
+                         const char *fragmentSource) const;
+
+    bool load(juce::uint64 key, GLenum &format, juce::MemoryBlock &binary) const;
+    void store(juce::uint64 key, GLenum format, const void *binary, size_t size) const;
+
+    /*
+     * Drops an entry the driver refused to load.
+     */
+    void remove(juce::uint64 key) const;
+
+private:
+    static juce::File getCacheDirectory();
+    juce::File getFileForKey(juce::uint64 key) const;
+
+    struct FileHeader {
+        juce::uint32 magic;
+        juce::uint32 version;
+        juce::uint32 format;
+        juce::uint32 size;
+    };
+
+    static constexpr juce::uint32 FILE_MAGIC = 0x42505453; // "STPB"
+    static constexpr juce::uint32 FILE_VERSION = 1;
+
+    juce::File directory;
+    juce::String driverId;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProgramCache)
+};
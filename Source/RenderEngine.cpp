@@ -0,0 +1,2506 @@
+/*
+  ==============================================================================
+
+    RenderEngine.cpp
+    Created: 16 Oct 2026 10:37:12pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RenderEngine.h"
+#include <algorithm>
+
+static const juce::String vert =
+"#version 330\n"
+"out vec2 texCoord;\n"
+"\n"
+"void main()\n"
+"{\n"
+"    float x = -1.0 + float((gl_VertexID & 1) << 2);\n"
+"    float y = -1.0 + float((gl_VertexID & 2) << 1);\n"
+"    texCoord.x = (x+1.0)*0.5;\n"
+"    texCoord.y = (y+1.0)*0.5;\n"
+"    gl_Position = vec4(x, y, 0, 1);\n"
+"}\n";
+
+RenderEngine::RenderEngine(ShadertoyAudioProcessor &processor, // IN / OUT
+                           juce::OpenGLContext &glContext)     // IN / OUT
+ : processor(processor),
+   glContext(glContext),
+   glState(glContext.extensions)
+{
+	processor.addStateListener(this);
+}
+
+RenderEngine::~RenderEngine()
+{
+    processor.removeStateListener(this);
+}
+
+bool
+RenderEngine::initialise(bool listenToProcessor) // IN
+{
+    if (!loadExtensions()) {
+	    goto failure;
+    }
+
+    /*
+     * Without parallel compilation in the driver, programs are built on
+     * a worker thread with a shared context, where one can be made.
+     */
+    if (!parallelShaderCompile) {
+        shaderCompiler.start(processor.getNumShaderFiles());
+    }
+    
+    /*
+     * Shader programs are built in the background (see
+     * pollProgramBuilds); until each one is ready its pass renders
+     * nothing.
+     */
+    programData.clear();
+    programData.resize(processor.getNumShaderFiles());
+    pendingPrograms.clear();
+    pendingPrograms.resize(processor.getNumShaderFiles());
+    {
+        // Everything is built from the current sources anyway
+        const juce::SpinLock::ScopedLockType lock(shaderReloadLock);
+        shaderReloads.clear();
+    }
+    for (int i = 0; i < processor.getNumShaderFiles(); i++) {
+        startProgramBuild(i, processor.getShaderString(i));
+    }
+
+    // Create the output framebuffer
+    if (!createFramebuffer(mOutputFramebuffer, 1)) {
+        goto failure;
+    }
+
+    // Create the aux framebuffers if needed
+    mAuxFramebuffers.resize(processor.getNumBuffers());
+    for (int i = 0; i < (int)mAuxFramebuffers.size(); i++) {
+        if (!createFramebuffer(mAuxFramebuffers[i], 2 + i)) {
+            goto failure;
+        }
+    }
+    passOrder.reserve(ShadertoyAudioProcessor::MAX_BUFFERS);
+    passRates.assign(mAuxFramebuffers.size(), PassRate());
+    frameCount = 0;
+
+    // Dynamic resolution just stays at full scale without timer queries
+    passTimer.initialise();
+    resolutionScaler.reset();
+
+    /*
+     * Only the output pass is scaled. It is stretched back over the
+     * window on presentation, whereas a scaled buffer would leave stale
+     * texels outside its viewport for anything sampling it by UV.
+     */
+    for (int i = 0; i < ShadertoyAudioProcessor::MAX_BUFFERS; i++) {
+        resolutionScaler.setScalable(AUX_PASS_ID_BASE + i, false);
+    }
+
+    profiler.reset();
+
+    firstRender = -1.0;
+    prevRender = -1.0;
+    firstAudioTimestamp = -1.0;
+    lastAudioTimestamp = -1.0;
+    lastAudioEndTimestamp = -1.0;
+    frameAudioDelay = 0;
+
+    for (int i = 0; i < MIDI_NUM_KEYS; i++) {
+        keyDownLast[i] = -1.0f;
+        keyUpLast[i] = -1.0f;
+    }
+
+    pitchWheel = 0.0f;
+    sustainPedal = 0.0f;
+    sostenutoPedal = 0.0f;
+    softPedal = 0.0f;
+
+#if RENDER_ENGINE_LOG_FPS == 1
+    avgFPS = 0.0;
+    lastFPSLog = 0.0;
+#endif
+
+    /*
+     * Everything the audio thread touches is allocated up front, before
+     * we start listening.
+     */
+    allocateAudioQueues();
+    numOverruns = 0;
+    numMidiEventsDropped = 0;
+
+    listeningToProcessor = listenToProcessor;
+    if (listeningToProcessor) {
+        processor.addAudioListener(this);
+    }
+    
+    validState = true;
+    return true;
+    
+failure:
+    validState = false;
+    return false;
+}
+
+void
+RenderEngine::release()
+{
+    if (listeningToProcessor) {
+        processor.removeAudioListener(this);
+        listeningToProcessor = false;
+    }
+    validState = false;
+
+    for (int i = 0; i < (int)pendingPrograms.size(); i++) {
+        discardProgramBuild(i);
+    }
+    pendingPrograms.clear();
+    shaderCompiler.stop();
+
+    for (auto &item : programData) {
+        if (item.program != nullptr) {
+            item.program->release();
+        }
+    }
+    programData.clear();
+
+    if (intrinsicsBuffer != 0) {
+        glContext.extensions.glDeleteBuffers(1, &intrinsicsBuffer);
+        intrinsicsBuffer = 0;
+    }
+    intrinsicsBlockUploaded = false;
+
+    releaseFramebuffer(mOutputFramebuffer);
+    for (auto &fb : mAuxFramebuffers) {
+        releaseFramebuffer(fb);
+    }
+    mAuxFramebuffers.clear();
+
+    passTimer.release();
+
+    audioRing.release();
+    midiFifo.reset();
+    midiEventPool.clear();
+    audioQueueSampleRate = 0.0;
+    audioQueueBlockSize = 0;
+
+    audioChannel0 = { };
+    maxSizeAudioChannel0 = 0;
+    audioChannel1 = { };
+    maxSizeAudioChannel1 = 0;
+}
+
+/*
+ * RenderEngine::updateIntrinsics
+ *    Converts this frame's intrinsic values once for every pass, and
+ *    uploads the ShadertoyIntrinsics uniform block shared by all
+ *    programs that declare it.
+ */
+void
+RenderEngine::updateIntrinsics(double currentAudioTimestamp, // IN
+                               int width,                    // IN
+                               int height)                   // IN
+{
+    FrameIntrinsics &frame = frameIntrinsics;
+
+    for (int i = 0; i < MIDI_NUM_KEYS; i++) {
+        frame.keyDown[i] = (GLfloat)keyDownLast[i];
+        frame.keyUp[i] = (GLfloat)keyUpLast[i];
+        frame.keyDownVelocity[i] = (GLfloat)keyDownVelocity[i];
+        frame.keyUpVelocity[i] = (GLfloat)keyUpVelocity[i];
+        frame.afterTouch[i] = (GLfloat)afterTouch[i];
+    }
+
+    frame.outputResolution[0] = 0.0f;
+    frame.outputResolution[1] = 0.0f;
+
+    int outputProgramIdx = getOutputProgramIdx();
+    if (processor.getShaderDestination(outputProgramIdx) == 1) {
+        float scale = resolutionScaler.getScale(OUTPUT_PASS_ID);
+
+        if (processor.getShaderFixedSizeBuffer(outputProgramIdx)) {
+            width = processor.getShaderFixedSizeWidth(outputProgramIdx);
+            height = processor.getShaderFixedSizeHeight(outputProgramIdx);
+        }
+
+        frame.outputResolution[0] = juce::jmin(scaleDimension(width, scale),
+                                               (GLfloat)mOutputFramebuffer.width);
+        frame.outputResolution[1] = juce::jmin(scaleDimension(height, scale),
+                                               (GLfloat)mOutputFramebuffer.height);
+    }
+
+    for (int i = 0; i < (int)mAuxFramebuffers.size(); i++) {
+        frame.auxResolution[i][0] = 0.0f;
+        frame.auxResolution[i][1] = 0.0f;
+
+        int bufferProgramIdx = getBufferProgramIdx(i);
+        if (bufferProgramIdx >= 0 &&
+            processor.getShaderDestination(bufferProgramIdx) == i + 2) {
+            if (processor.getShaderFixedSizeBuffer(bufferProgramIdx)) {
+                frame.auxResolution[i][0] = (GLfloat)processor.getShaderFixedSizeWidth(bufferProgramIdx);
+                frame.auxResolution[i][1] = (GLfloat)processor.getShaderFixedSizeHeight(bufferProgramIdx);
+            } else {
+                frame.auxResolution[i][0] = (GLfloat)mAuxFramebuffers[i].width;
+                frame.auxResolution[i][1] = (GLfloat)mAuxFramebuffers[i].height;
+            }
+        }
+    }
+
+    if (intrinsicsBuffer == 0) {
+        return;
+    }
+
+    IntrinsicsBlock &block = intrinsicsBlock;
+    block.resolution[0] = frame.outputResolution[0];
+    block.resolution[1] = frame.outputResolution[1];
+    for (int i = 0; i < 4; i++) {
+        bool exists = i < (int)mAuxFramebuffers.size();
+        block.resolutionBuffer[i][0] = exists ? frame.auxResolution[i][0] : 0.0f;
+        block.resolutionBuffer[i][1] = exists ? frame.auxResolution[i][1] : 0.0f;
+    }
+    block.time = (GLfloat)currentAudioTimestamp;
+    block.sampleRate = (GLfloat)mSampleRate;
+    block.pitchWheel = (GLfloat)pitchWheel;
+    block.sustainPedal = (GLfloat)sustainPedal;
+    block.sostenutoPedal = (GLfloat)sostenutoPedal;
+    block.softPedal = (GLfloat)softPedal;
+    block.channelPressure = (GLfloat)channelPressure;
+    for (int i = 0; i < MIDI_NUM_KEYS; i++) {
+        block.keyDown[i].value = frame.keyDown[i];
+        block.keyUp[i].value = frame.keyUp[i];
+        block.keyDownVelocity[i].value = frame.keyDownVelocity[i];
+        block.keyUpVelocity[i].value = frame.keyUpVelocity[i];
+        block.afterTouch[i].value = frame.afterTouch[i];
+    }
+
+    /*
+     * The buffer keeps its contents between frames, so only re-specify
+     * it when something in the block actually changed.
+     */
+    if (intrinsicsBlockUploaded &&
+        memcmp(&uploadedIntrinsicsBlock, &block, sizeof(IntrinsicsBlock)) == 0) {
+        frameUniformsSkipped++;
+    } else {
+        glContext.extensions.glBindBuffer(GL_UNIFORM_BUFFER, intrinsicsBuffer);
+        glContext.extensions.glBufferData(GL_UNIFORM_BUFFER, sizeof(IntrinsicsBlock),
+                                          &block, GL_STREAM_DRAW);
+        uploadedIntrinsicsBlock = block;
+        intrinsicsBlockUploaded = true;
+        frameUniformsUploaded++;
+    }
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, INTRINSICS_BLOCK_BINDING, intrinsicsBuffer);
+}
+
+/*
+ * RenderEngine::setProgramIntrinsics
+ *    Uploads the per-program uniforms: parameters, audio windows, samplers,
+ *    and the loose intrinsics of programs that don't use the
+ *    ShadertoyIntrinsics block.
+ */
+void
+RenderEngine::setProgramIntrinsics(int programIdx,               // IN
+                                   double currentAudioTimestamp) // IN
+{
+    ProgramData &program = programData[programIdx];
+    const FrameIntrinsics &frame = frameIntrinsics;
+
+    if (program.audioChannel0.uniform != nullptr && audioChannel0.samples != nullptr) {
+        readAudioHistory(audioChannel0, audioWindow, program.sizeAudioChannel0,
+                         frameAudioDelay);
+        setTrackedUniform(program.audioChannel0, audioWindow, program.sizeAudioChannel0);
+    }
+
+    if (program.audioChannel1.uniform != nullptr && audioChannel1.samples != nullptr) {
+        readAudioHistory(audioChannel1, audioWindow, program.sizeAudioChannel1,
+                         frameAudioDelay);
+        setTrackedUniform(program.audioChannel1, audioWindow, program.sizeAudioChannel1);
+    }
+
+    setParamUniforms(program);
+
+    // The writer's target count can change without this program being
+    // rebuilt, so a missing attachment reads as black instead of failing
+    for (auto &sampler : program.bufferSamplers) {
+        const Framebuffer &fb = mAuxFramebuffers[sampler.bufferIdx];
+        glState.bindTexture(sampler.textureUnit,
+                            sampler.attachment < fb.numTargets ? fb.textureObj[sampler.attachment] : 0);
+        setTrackedUniform(sampler.tracked, sampler.textureUnit);
+    }
+
+    /*
+     * Only iResolutionBufferA..D live in the intrinsics block, so these
+     * are set either way.
+     */
+    for (auto &resolution : program.bufferResolutions) {
+        setTrackedUniform(resolution.tracked, frame.auxResolution[resolution.bufferIdx][0],
+                          frame.auxResolution[resolution.bufferIdx][1]);
+    }
+
+    if (program.usesIntrinsicsBlock) {
+        return;
+    }
+
+    /*
+     * Legacy loose uniforms
+     */
+    setTrackedUniform(program.sampleRateIntrinsic, (GLfloat)mSampleRate);
+    setTrackedUniform(program.keyDownIntrinsic, frame.keyDown, MIDI_NUM_KEYS);
+    setTrackedUniform(program.keyUpIntrinsic, frame.keyUp, MIDI_NUM_KEYS);
+    setTrackedUniform(program.keyDownVelocityIntrinsic, frame.keyDownVelocity, MIDI_NUM_KEYS);
+    setTrackedUniform(program.keyUpVelocityIntrinsic, frame.keyUpVelocity, MIDI_NUM_KEYS);
+    setTrackedUniform(program.afterTouchIntrinsic, frame.afterTouch, MIDI_NUM_KEYS);
+    setTrackedUniform(program.pitchWheelIntrinsic, (GLfloat)pitchWheel);
+    setTrackedUniform(program.sustainPedalIntrinsic, (GLfloat)sustainPedal);
+    setTrackedUniform(program.sostenutoPedalIntrinsic, (GLfloat)sostenutoPedal);
+    setTrackedUniform(program.softPedalIntrinsic, (GLfloat)softPedal);
+    setTrackedUniform(program.channelPressureIntrinsic, (GLfloat)channelPressure);
+    setTrackedUniform(program.timeIntrinsic, (GLfloat)currentAudioTimestamp);
+    setTrackedUniform(program.outputResolutionIntrinsic, frame.outputResolution[0],
+                      frame.outputResolution[1]);
+}
+
+/*
+ * RenderEngine::setParamUniforms
+ *    Uploads the float0..255 / int0..255 parameters that changed since
+ *    they were last sent to this program.
+ */
+void
+RenderEngine::setParamUniforms(ProgramData &program) // IN / OUT
+{
+    for (ParamUniform &param : program.uniformFloats) {
+        GLfloat val = (GLfloat)getUniformFloat(param.paramIdx);
+        juce::uint32 bits;
+        memcpy(&bits, &val, sizeof(bits));
+
+        if (param.hasUploaded && param.uploaded == bits) {
+            frameUniformsSkipped++;
+            continue;
+        }
+
+        glContext.extensions.glUniform1f(param.location, val);
+        param.uploaded = bits;
+        param.hasUploaded = true;
+        frameUniformsUploaded++;
+    }
+
+    for (ParamUniform &param : program.uniformInts) {
+        GLint val = (GLint)getUniformInt(param.paramIdx);
+
+        if (param.hasUploaded && param.uploaded == (juce::uint32)val) {
+            frameUniformsSkipped++;
+            continue;
+        }
+
+        glContext.extensions.glUniform1i(param.location, val);
+        param.uploaded = (juce::uint32)val;
+        param.hasUploaded = true;
+        frameUniformsUploaded++;
+    }
+}
+
+/*
+ * RenderEngine::getUniformFloat
+ *    Parameter reads go through these so a replay can stand in for the
+ *    live parameters (see setParameterOverride).
+ */
+float
+RenderEngine::getUniformFloat(int i) // IN
+{
+    return parameterOverride != nullptr ? processor.getUniformFloat(i, *parameterOverride)
+                                        : processor.getUniformFloat(i);
+}
+
+int
+RenderEngine::getUniformInt(int i) // IN
+{
+    return parameterOverride != nullptr ? processor.getUniformInt(i, *parameterOverride)
+                                        : processor.getUniformInt(i);
+}
+
+/*
+ * RenderEngine::getPassName
+ *    Any thread. Names the profiler's pass ids after the buffers as they
+ *    are called now.
+ */
+juce::String
+RenderEngine::getPassName(int passId) // IN
+{
+    int bufferId = passId - AUX_PASS_ID_BASE;
+
+    if (passId == OUTPUT_PASS_ID) {
+        return "Output";
+    } else if (bufferId >= 0 && bufferId < processor.getNumBuffers()) {
+        return "Buffer " + processor.getBufferName(bufferId);
+    }
+
+    return juce::String(passId);
+}
+
+int
+RenderEngine::getOutputProgramIdx()
+{
+    return parameterOverride != nullptr ? processor.getOutputProgramIdx(*parameterOverride)
+                                        : processor.getOutputProgramIdx();
+}
+
+int
+RenderEngine::getBufferProgramIdx(int bufferId) // IN
+{
+    return parameterOverride != nullptr ? processor.getBufferProgramIdx(bufferId, *parameterOverride)
+                                        : processor.getBufferProgramIdx(bufferId);
+}
+
+/*
+ * RenderEngine::markUniformUploaded
+ *    Compares a value against the shadow copy of what was last sent to
+ *    the uniform. Returns true (and updates the shadow) if the value
+ *    needs uploading, false if the driver already has it.
+ */
+bool
+RenderEngine::markUniformUploaded(TrackedUniform &tracked, // IN / OUT
+                                  const void *words,       // IN
+                                  int numWords)            // IN
+{
+    const size_t numBytes = sizeof(juce::uint32) * (size_t)numWords;
+
+    if (tracked.uploaded.size() == (size_t)numWords &&
+        memcmp(tracked.uploaded.data(), words, numBytes) == 0) {
+        frameUniformsSkipped++;
+        return false;
+    }
+
+    tracked.uploaded.resize(numWords);
+    memcpy(tracked.uploaded.data(), words, numBytes);
+    frameUniformsUploaded++;
+    return true;
+}
+
+void
+RenderEngine::setTrackedUniform(TrackedUniform &tracked, // IN / OUT
+                                GLfloat value)           // IN
+{
+    if (tracked.uniform != nullptr && markUniformUploaded(tracked, &value, 1)) {
+        tracked.uniform->set(value);
+    }
+}
+
+void
+RenderEngine::setTrackedUniform(TrackedUniform &tracked, // IN / OUT
+                                GLfloat x,               // IN
+                                GLfloat y)               // IN
+{
+    const GLfloat value[2] = { x, y };
+    if (tracked.uniform != nullptr && markUniformUploaded(tracked, value, 2)) {
+        tracked.uniform->set(x, y);
+    }
+}
+
+void
+RenderEngine::setTrackedUniform(TrackedUniform &tracked, // IN / OUT
+                                GLint value)             // IN
+{
+    if (tracked.uniform != nullptr && markUniformUploaded(tracked, &value, 1)) {
+        tracked.uniform->set(value);
+    }
+}
+
+void
+RenderEngine::setTrackedUniform(TrackedUniform &tracked, // IN / OUT
+                                const GLfloat *values,   // IN
+                                int count)               // IN
+{
+    if (tracked.uniform != nullptr && markUniformUploaded(tracked, values, count)) {
+        tracked.uniform->set(values, count);
+    }
+}
+
+/*
+ * RenderEngine::findPassProgram
+ *    Returns the index of the built program rendering to destinationId
+ *    (1 = output, 2 + i = aux buffer i), or -1 if there is none.
+ */
+int
+RenderEngine::findPassProgram(int destinationId) // IN
+{
+    if (destinationId - 2 >= (int)mAuxFramebuffers.size()) {
+        return -1;
+    }
+
+    int programIdx = destinationId == 1 ? getOutputProgramIdx()
+                                        : getBufferProgramIdx(destinationId - 2);
+
+    if (programIdx < 0 || programIdx >= (int)programData.size() ||
+        programData[programIdx].program == nullptr ||
+        processor.getShaderDestination(programIdx) != destinationId) {
+        return -1;
+    }
+
+    return programIdx;
+}
+
+GLfloat
+RenderEngine::scaleDimension(int size,    // IN
+                             float scale) // IN
+{
+    return (GLfloat)juce::jmax(1, (int)(size * scale + 0.5f));
+}
+
+/*
+ * RenderEngine::schedulePasses
+ *    Builds this frame's list of aux passes. A buffer is live if a live
+ *    pass samples it, starting from the output, so buffers nothing
+ *    reachable reads are skipped. Live buffers are ordered so each is
+ *    rendered after the buffers it samples (Kahn's algorithm, ties
+ *    broken by buffer index). Buffers in a dependency cycle fall back to
+ *    declared order, and read the previous frame's contents of any
+ *    buffer that comes later.
+ */
+void
+RenderEngine::schedulePasses()
+{
+    constexpr int MAX_BUFFERS = ShadertoyAudioProcessor::MAX_BUFFERS;
+    const int numBuffers = (int)mAuxFramebuffers.size();
+    int passProgram[MAX_BUFFERS];
+    bool live[MAX_BUFFERS] = { };
+    bool scheduled[MAX_BUFFERS] = { };
+    int numInputs[MAX_BUFFERS] = { }; // Unscheduled live buffers each pass samples
+    int stack[MAX_BUFFERS];
+    int stackSize = 0;
+
+    for (int i = 0; i < numBuffers; i++) {
+        passProgram[i] = findPassProgram(2 + i);
+    }
+
+    int programIdx = findPassProgram(1);
+    for (;;) {
+        if (programIdx >= 0) {
+            for (auto &sampler : programData[programIdx].bufferSamplers) {
+                if (!live[sampler.bufferIdx]) {
+                    live[sampler.bufferIdx] = true;
+                    stack[stackSize++] = sampler.bufferIdx;
+                }
+            }
+        }
+
+        if (stackSize == 0) {
+            break;
+        }
+
+        programIdx = passProgram[stack[--stackSize]];
+    }
+
+    for (int i = 0; i < numBuffers; i++) {
+        if (live[i] && passProgram[i] >= 0) {
+            for (auto &sampler : programData[passProgram[i]].bufferSamplers) {
+                if (sampler.bufferIdx != i) {
+                    numInputs[i]++;
+                }
+            }
+        }
+    }
+
+    passOrder.clear();
+    for (;;) {
+        int next = -1;
+        int firstUnscheduled = -1;
+
+        for (int i = 0; i < numBuffers && next < 0; i++) {
+            if (live[i] && !scheduled[i]) {
+                if (firstUnscheduled < 0) {
+                    firstUnscheduled = i;
+                }
+                if (numInputs[i] == 0) {
+                    next = i;
+                }
+            }
+        }
+
+        if (next < 0) {
+            next = firstUnscheduled; // Cycle, or done
+        }
+
+        if (next < 0) {
+            break;
+        }
+
+        scheduled[next] = true;
+        passOrder.push_back(next);
+
+        for (int i = 0; i < numBuffers; i++) {
+            if (live[i] && !scheduled[i] && passProgram[i] >= 0) {
+                for (auto &sampler : programData[passProgram[i]].bufferSamplers) {
+                    if (sampler.bufferIdx == next) {
+                        numInputs[i]--;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * RenderEngine::selectPassUpdates
+ *    Drops the passes whose update rate says they can skip this frame
+ *    from passOrder. A skipped buffer keeps its last texture (nothing is
+ *    swapped), and still counts as live, so buffers it samples are
+ *    scheduled as usual.
+ */
+void
+RenderEngine::selectPassUpdates(double now) // IN
+{
+    bool changed = false;
+
+    for (int i = 0; i < (int)passRates.size(); i++) {
+        int programIdx = findPassProgram(2 + i);
+        int divisor = programIdx >= 0 ? processor.getShaderUpdateDivisor(programIdx) : 1;
+        double hz = programIdx >= 0 ? processor.getShaderUpdateHz(programIdx) : 0.0;
+
+        if (divisor != passRates[i].divisor || hz != passRates[i].hz) {
+            passRates[i].divisor = divisor;
+            passRates[i].hz = hz;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        assignPassPhases(now);
+    }
+
+    auto skip = [this, now](int bufferIdx) {
+        PassRate &rate = passRates[bufferIdx];
+
+        if (rate.hz > 0.0) {
+            if (now < rate.nextUpdate) {
+                return true;
+            }
+
+            // Keep the phase unless we fell more than a period behind
+            rate.nextUpdate += 1.0 / rate.hz;
+            if (rate.nextUpdate < now) {
+                rate.nextUpdate = now + 1.0 / rate.hz;
+            }
+            return false;
+        }
+
+        return (int)(frameCount % (juce::uint64)rate.divisor) != rate.phase;
+    };
+
+    passOrder.erase(std::remove_if(passOrder.begin(), passOrder.end(), skip), passOrder.end());
+    frameCount++;
+}
+
+/*
+ * RenderEngine::assignPassPhases
+ *    Staggers divided passes so their work spreads across frames. Over
+ *    one period of all divisors (their LCM, capped), each pass in turn,
+ *    longest divisor first, takes the phase whose frames are currently
+ *    least loaded. Passes sharing an update rate in Hz are offset evenly
+ *    within their period.
+ */
+void
+RenderEngine::assignPassPhases(double now) // IN
+{
+    int window = 1;
+    for (auto &rate : passRates) {
+        if (rate.hz <= 0.0 && rate.divisor > 1) {
+            int a = window;
+            int b = rate.divisor;
+            while (b != 0) {
+                int t = a % b;
+                a = b;
+                b = t;
+            }
+            window = window / a * rate.divisor;
+            window = juce::jmin(window, MAX_PHASE_WINDOW);
+        }
+    }
+
+    std::vector<int> order;
+    for (int i = 0; i < (int)passRates.size(); i++) {
+        if (passRates[i].hz <= 0.0 && passRates[i].divisor > 1) {
+            order.push_back(i);
+        } else {
+            passRates[i].phase = 0;
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return passRates[a].divisor > passRates[b].divisor;
+    });
+
+    std::vector<int> load(window, 0);
+    for (int i : order) {
+        PassRate &rate = passRates[i];
+        int bestPhase = 0;
+        int bestPeak = std::numeric_limits<int>::max();
+
+        for (int phase = 0; phase < rate.divisor; phase++) {
+            int peak = 0;
+            for (int f = phase; f < window; f += rate.divisor) {
+                peak = juce::jmax(peak, load[f]);
+            }
+            if (peak < bestPeak) {
+                bestPeak = peak;
+                bestPhase = phase;
+            }
+        }
+
+        for (int f = bestPhase; f < window; f += rate.divisor) {
+            load[f]++;
+        }
+
+        // Phases are relative to the frame count, so shift into its frame
+        rate.phase = (int)((frameCount + bestPhase) % (juce::uint64)rate.divisor);
+    }
+
+    for (int i = 0; i < (int)passRates.size(); i++) {
+        if (passRates[i].hz <= 0.0) {
+            continue;
+        }
+
+        int rank = 0;
+        int count = 0;
+        for (int j = 0; j < (int)passRates.size(); j++) {
+            if (passRates[j].hz == passRates[i].hz) {
+                rank += j < i ? 1 : 0;
+                count++;
+            }
+        }
+
+        passRates[i].nextUpdate = now + (double)rank / count / passRates[i].hz;
+    }
+}
+
+void
+RenderEngine::renderAuxBuffer(int bufferIdx,                // IN
+                              double currentAudioTimestamp) // IN
+{
+    int programIdx = findPassProgram(2 + bufferIdx);
+    if (programIdx >= 0) {
+        ProgramData &program = programData[programIdx];
+        glState.useProgram(program.program->getProgramID());
+
+        juce::int64 uniformStart = juce::Time::getHighResolutionTicks();
+        setProgramIntrinsics(programIdx, currentAudioTimestamp);
+        frameUniformTicks += juce::Time::getHighResolutionTicks() - uniformStart;
+
+        // The active size already accounts for fixed size and dynamic resolution
+        Framebuffer &fb = mAuxFramebuffers[bufferIdx];
+        glState.bindFramebuffer(fb.backFramebufferObj);
+        glState.viewport(0, 0, (GLsizei)frameIntrinsics.auxResolution[bufferIdx][0],
+                         (GLsizei)frameIntrinsics.auxResolution[bufferIdx][1]);
+
+        passTimer.beginPass(AUX_PASS_ID_BASE + bufferIdx);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        passTimer.endPass();
+
+        // Later passes (and this one, next frame) sample what was just drawn
+        std::swap(fb.framebufferObj, fb.backFramebufferObj);
+        std::swap(fb.textureObj, fb.backTextureObj);
+
+        generateMipmaps(fb);
+    }
+}
+
+void
+RenderEngine::renderOutputBuffer(double currentAudioTimestamp) // IN
+{
+    // The active size already accounts for fixed size and dynamic resolution
+    glState.bindFramebuffer(mOutputFramebuffer.framebufferObj);
+
+    int programIdx = findPassProgram(1);
+    if (programIdx >= 0) {
+        ProgramData &program = programData[programIdx];
+        glState.useProgram(program.program->getProgramID());
+
+        juce::int64 uniformStart = juce::Time::getHighResolutionTicks();
+        setProgramIntrinsics(programIdx, currentAudioTimestamp);
+        frameUniformTicks += juce::Time::getHighResolutionTicks() - uniformStart;
+
+        glState.viewport(0, 0, (GLsizei)frameIntrinsics.outputResolution[0],
+                         (GLsizei)frameIntrinsics.outputResolution[1]);
+
+        passTimer.beginPass(OUTPUT_PASS_ID);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        passTimer.endPass();
+
+        generateMipmaps(mOutputFramebuffer);
+    } else {
+        /*
+         * Undefined program, output stays black (and zero-sized)
+         */
+        glState.viewport(0, 0, mOutputFramebuffer.width, mOutputFramebuffer.height);
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+}
+
+void
+RenderEngine::renderFrame(int width,             // IN
+                          int height,            // IN
+                          double now,            // IN
+                          double audioTimestamp) // IN
+{
+    if (validState) {
+        juce::int64 frameStart = juce::Time::getHighResolutionTicks();
+        double elapsedSeconds = -1.0;
+        double currentAudioTimestamp = -1.0;
+
+        if (processor.getPreparedBlockSize() != audioQueueBlockSize ||
+            processor.getPreparedSampleRate() != audioQueueSampleRate) {
+            /*
+             * The host changed its block size or sample rate. Stop listening
+             * while the queues are resized so the audio thread never sees
+             * them half-built.
+             */
+            if (listeningToProcessor) {
+                processor.removeAudioListener(this);
+            }
+            drainAudioRing();
+            allocateAudioQueues();
+            if (listeningToProcessor) {
+                processor.addAudioListener(this);
+            }
+        }
+
+        drainAudioRing();
+        pollProgramBuilds();
+
+#if RENDER_ENGINE_LOG_FPS == 1
+        if (prevRender >= 0.0) {
+            double instFPS = 1.0 / (now - prevRender);
+            if (avgFPS > 0.0) {
+                const double a = 0.96;
+                avgFPS = avgFPS * a + instFPS * (1.0 - a);
+            }  else {
+                avgFPS = instFPS;
+            }
+        }
+
+        if (avgFPS > 0.0) {
+            if (now - lastFPSLog > 1.0) {
+                logMessage("FPS: " + std::to_string(avgFPS));
+                lastFPSLog = now;
+            }
+        }
+#endif
+
+#if RENDER_ENGINE_LOG_OVERRUNS == 1
+        if (getNumOverruns() != lastLoggedOverruns) {
+            lastLoggedOverruns = getNumOverruns();
+            logMessage("Render thread fell behind, overruns: " +
+                       std::to_string(lastLoggedOverruns));
+        }
+
+        if (getNumMidiEventsDropped() != lastLoggedMidiEventsDropped) {
+            lastLoggedMidiEventsDropped = getNumMidiEventsDropped();
+            logMessage("Midi event pool full, events dropped: " +
+                       std::to_string(lastLoggedMidiEventsDropped));
+        }
+#endif
+
+        if (firstRender < 0) {
+            firstRender = now;
+        }
+        elapsedSeconds = now - firstRender;
+
+        if (firstAudioTimestamp >= 0.0) {
+            int delaySamples = int(mSampleRate * DELAY_LATENCY);
+
+            if (audioTimestamp >= 0.0) {
+                currentAudioTimestamp = audioTimestamp;
+                frameAudioDelay = juce::jlimit(0, delaySamples,
+                                               (int)std::llround(mSampleRate *
+                                                                 (lastAudioEndTimestamp -
+                                                                  currentAudioTimestamp)));
+            } else {
+                currentAudioTimestamp = juce::jmin(lastAudioTimestamp,
+                                                   juce::jmax(firstAudioTimestamp - DELAY_LATENCY +
+                                                              elapsedSeconds,
+                                                              lastAudioTimestamp - DELAY_LATENCY));
+
+                /*
+                 * Calculate the difference between simulated audio time and the
+                 * audio timestamp last provided by handleAudioFrame. Use this to
+                 * advance the audio buffer given to the shader at a constant rate.
+                 * If this is not done, there will be variable jumps in audio because
+                 * handleAudioFrame is called at unpredictable time intervals.
+                 */
+                double audioTimeDiff = currentAudioTimestamp - lastAudioTimestamp;
+                int samplePos = juce::jlimit(0, delaySamples,
+                                             int(mSampleRate * (audioTimeDiff + DELAY_LATENCY)));
+                frameAudioDelay = delaySamples - samplePos;
+            }
+
+            applyMidiEvents(currentAudioTimestamp);
+        }
+
+        frameUniformsUploaded = 0;
+        frameUniformsSkipped = 0;
+        frameUniformTicks = 0;
+
+        updateFramebufferTextures();
+        if (!ensureOutputFramebuffer(width, height)) {
+            validState = false;
+            return;
+        }
+
+        juce::uint64 frameNumber = frameCount; // selectPassUpdates advances it
+        passTimer.beginFrame(frameNumber);
+        profiler.addGpuTimes(passTimer);
+        if (processor.getDynamicResolution() && audioTimestamp < 0.0) {
+            resolutionScaler.setTarget(processor.getTargetFps(),
+                                       processor.getMinResolutionScale() / 100.0f, 1.0f);
+            resolutionScaler.update(passTimer);
+        } else {
+            resolutionScaler.reset();
+        }
+
+        /*
+         * JUCE (and anything else sharing the context) may have changed
+         * bindings since the last frame.
+         */
+        glState.invalidate();
+        glState.resetCounters();
+
+        juce::int64 uniformStart = juce::Time::getHighResolutionTicks();
+        updateIntrinsics(currentAudioTimestamp, width, height);
+        frameUniformTicks += juce::Time::getHighResolutionTicks() - uniformStart;
+
+        schedulePasses();
+        selectPassUpdates(now);
+
+        for (int bufferIdx : passOrder) {
+            renderAuxBuffer(bufferIdx, currentAudioTimestamp);
+        }
+        
+        renderOutputBuffer(currentAudioTimestamp);
+
+        passTimer.endFrame();
+
+        /*
+         * CPU time covers the engine's part of the frame, not presenting
+         * it or the driver's own work after the caller is done (swap,
+         * JUCE's component overlay).
+         */
+        profiler.addFrame(frameNumber, now,
+                          juce::Time::highResolutionTicksToSeconds(
+                              juce::Time::getHighResolutionTicks() - frameStart) * 1000.0,
+                          juce::Time::highResolutionTicksToSeconds(frameUniformTicks) * 1000.0);
+
+        numUniformsUploaded = frameUniformsUploaded;
+        numUniformsSkipped = frameUniformsSkipped;
+        numStateChangesIssued = glState.getNumIssued();
+        numStateChangesFiltered = glState.getNumFiltered();
+
+#if RENDER_ENGINE_LOG_UNIFORM_STATS == 1
+        if (now - lastUniformStatsLog > 1.0) {
+            logMessage("Uniforms uploaded: " + std::to_string(frameUniformsUploaded) +
+                       ", skipped: " + std::to_string(frameUniformsSkipped));
+            lastUniformStatsLog = now;
+        }
+#endif
+
+#if RENDER_ENGINE_LOG_STATE_STATS == 1
+        if (now - lastStateStatsLog > 1.0) {
+            logMessage("GL state changes issued: " + std::to_string(glState.getNumIssued()) +
+                       ", filtered: " + std::to_string(glState.getNumFiltered()));
+            lastStateStatsLog = now;
+        }
+#endif
+
+        prevRender = now;
+    }
+}
+
+/*
+ * RenderEngine::allocateAudioHistory
+ *    Sizes a history buffer to the next power of two that can hold the
+ *    requested number of samples, and clears it.
+ */
+void
+RenderEngine::allocateAudioHistory(AudioHistory &history, // OUT
+                                   int minSize)           // IN
+{
+    juce::uint32 capacity = juce::nextPowerOfTwo(minSize);
+    history.samples.reset(new float[capacity]);
+    memset(history.samples.get(), 0, capacity * sizeof(float));
+    history.mask = capacity - 1;
+    history.writePos = 0;
+}
+
+/*
+ * RenderEngine::advanceAudioHistory
+ *    Appends new samples to the history. Cost is proportional to the
+ *    number of new samples, not the size of the history.
+ */
+void
+RenderEngine::advanceAudioHistory(AudioHistory &history, // IN / OUT
+                                  const float *src,      // IN: The buffer filled with new samples
+                                  int srcSize)           // IN: The number of new samples
+{
+    juce::uint32 capacity = history.mask + 1;
+    if ((juce::uint32)srcSize > capacity) {
+        src += srcSize - capacity;
+        srcSize = (int)capacity;
+    }
+
+    juce::uint32 start = history.writePos & history.mask;
+    juce::uint32 size1 = juce::jmin((juce::uint32)srcSize, capacity - start);
+    memcpy(history.samples.get() + start, src, size1 * sizeof(float));
+    memcpy(history.samples.get(), src + size1, (srcSize - size1) * sizeof(float));
+    history.writePos += (juce::uint32)srcSize;
+}
+
+/*
+ * RenderEngine::readAudioHistory
+ *    Linearizes a window of the history into dst. The window holds
+ *    `size` samples and ends `delay` samples before the newest one.
+ */
+void
+RenderEngine::readAudioHistory(const AudioHistory &history, // IN
+                               float *dst,                  // OUT
+                               int size,                    // IN
+                               int delay)                   // IN
+{
+    juce::uint32 capacity = history.mask + 1;
+    juce::uint32 start = (history.writePos - (juce::uint32)(delay + size)) & history.mask;
+    juce::uint32 size1 = juce::jmin((juce::uint32)size, capacity - start);
+    memcpy(dst, history.samples.get() + start, size1 * sizeof(float));
+    memcpy(dst + size1, history.samples.get(), (size - size1) * sizeof(float));
+}
+
+/*
+ * RenderEngine::growAudioHistory
+ *    Reallocates a history buffer if it can't serve a window of maxSize
+ *    samples at the current delay. The old contents are dropped.
+ */
+void
+RenderEngine::growAudioHistory(AudioHistory &history, // IN / OUT
+                               GLint maxSize)         // IN
+{
+    if (maxSize <= 0) {
+        return;
+    }
+
+    juce::uint32 needed = (juce::uint32)(maxSize + (GLint)(mSampleRate * DELAY_LATENCY));
+    if (history.samples == nullptr || history.mask + 1 < needed) {
+        allocateAudioHistory(history, (int)needed);
+    }
+}
+
+/*
+ * RenderEngine::allocateAudioQueues
+ *    Sizes the audio ring and midi event pool from the processor's
+ *    prepareToPlay parameters. Must not be called while registered as
+ *    an audio listener.
+ */
+void
+RenderEngine::allocateAudioQueues()
+{
+    audioQueueSampleRate = processor.getPreparedSampleRate();
+    audioQueueBlockSize = juce::jmax(1, processor.getPreparedBlockSize());
+
+    int sampleCapacity = juce::jmax(audioQueueBlockSize * MIN_AUDIO_QUEUE_BLOCKS,
+                                    (int)std::ceil(audioQueueSampleRate * AUDIO_QUEUE_SECONDS));
+    int blockCapacity = juce::jmax(MIN_AUDIO_QUEUE_BLOCKS, sampleCapacity / MIN_HOST_BLOCK_SIZE);
+    int midiCapacity = MIDI_EVENTS_PER_BLOCK * (sampleCapacity / audioQueueBlockSize);
+
+    audioRing.allocate(2, sampleCapacity, blockCapacity);
+    audioRingScratch.setSize(2, sampleCapacity);
+
+    midiEventPool.assign(midiCapacity + 1, MidiEvent());
+    midiFifo.setTotalSize(midiCapacity + 1);
+    midiFifo.reset();
+}
+
+/*
+ * RenderEngine::drainAudioRing
+ *    Pulls every audio block queued by handleAudioFrame into the
+ *    history buffers. Called on the render thread.
+ */
+void
+RenderEngine::drainAudioRing()
+{
+    AudioRing::BlockInfo block;
+
+    while (audioRing.pop(block, audioRingScratch)) {
+        if (firstAudioTimestamp < 0.0 || mSampleRate != block.sampleRate) {
+            firstAudioTimestamp = block.timestamp;
+            firstRender = -1.0;
+            prevRender = -1.0;
+
+            /*
+             * Throw away midi left over from before the restart
+             */
+            int start1, size1, start2, size2;
+            midiFifo.prepareToRead(1, start1, size1, start2, size2);
+            while (size1 > 0 && midiEventPool[start1].time < block.timestamp) {
+                midiFifo.finishedRead(1);
+                midiFifo.prepareToRead(1, start1, size1, start2, size2);
+            }
+
+            if (maxSizeAudioChannel0 > 0) {
+                allocateAudioHistory(audioChannel0, maxSizeAudioChannel0 +
+                                     (GLint)(block.sampleRate * DELAY_LATENCY));
+            }
+
+            if (maxSizeAudioChannel1 > 0) {
+                allocateAudioHistory(audioChannel1, maxSizeAudioChannel1 +
+                                     (GLint)(block.sampleRate * DELAY_LATENCY));
+            }
+        }
+
+        if (audioChannel0.samples != nullptr) {
+            advanceAudioHistory(audioChannel0, audioRingScratch.getReadPointer(0),
+                                block.numSamples);
+        }
+
+        if (audioChannel1.samples != nullptr) {
+            advanceAudioHistory(audioChannel1, audioRingScratch.getReadPointer(1),
+                                block.numSamples);
+        }
+
+        mSampleRate = block.sampleRate;
+        lastAudioTimestamp = block.timestamp;
+        lastAudioEndTimestamp = block.timestamp + block.numSamples / block.sampleRate;
+    }
+}
+
+/*
+ * RenderEngine::applyMidiEvents
+ *    Applies every queued midi event that is due at the current
+ *    (delayed) audio time. Each event keeps the exact sample it
+ *    arrived on, so notes within a host block get distinct times.
+ *    Called on the render thread.
+ */
+void
+RenderEngine::applyMidiEvents(double currentAudioTimestamp) // IN
+{
+    int start1, size1, start2, size2;
+    midiFifo.prepareToRead(1, start1, size1, start2, size2);
+
+    while (size1 > 0) {
+        const MidiEvent &event = midiEventPool[start1];
+        const double eventTime = event.time;
+        if (eventTime > currentAudioTimestamp) {
+            break;
+        }
+
+        switch (event.type) {
+        case MIDI_NOTE_ON:
+            keyDownLast[event.note] = eventTime;
+            keyDownVelocity[event.note] = event.value;
+            break;
+        case MIDI_NOTE_OFF:
+            keyUpLast[event.note] = eventTime;
+            keyUpVelocity[event.note] = event.value;
+            break;
+        case MIDI_AFTERTOUCH:
+            afterTouch[event.note] = event.value;
+            break;
+        case MIDI_PITCH_WHEEL:
+            pitchWheel = event.value;
+            break;
+        case MIDI_SUSTAIN_PEDAL:
+            sustainPedal = event.value;
+            break;
+        case MIDI_SOSTENUTO_PEDAL:
+            sostenutoPedal = event.value;
+            break;
+        case MIDI_SOFT_PEDAL:
+            softPedal = event.value;
+            break;
+        case MIDI_CHANNEL_PRESSURE:
+            channelPressure = event.value;
+            break;
+        }
+
+        midiFifo.finishedRead(1);
+        midiFifo.prepareToRead(1, start1, size1, start2, size2);
+    }
+}
+
+/*
+ * RenderEngine::decodeMidiEvent
+ *    Decodes a raw midi message into a MidiEvent. Returns false for
+ *    messages that don't drive any intrinsic. Realtime safe.
+ */
+bool
+RenderEngine::decodeMidiEvent(const juce::uint8 *data, // IN
+                              int numBytes,            // IN
+                              MidiEvent &event)        // OUT
+{
+    if (numBytes < 2) {
+        return false;
+    }
+
+    const juce::uint8 status = data[0] & 0xf0;
+    const juce::uint8 data1 = data[1] & 0x7f;
+    const juce::uint8 data2 = numBytes > 2 ? (data[2] & 0x7f) : 0;
+    event.channel = (juce::uint8)((data[0] & 0x0f) + 1);
+    event.note = data1;
+
+    switch (status) {
+    case 0x90:
+        // Note on with zero velocity is a note off
+        event.type = data2 > 0 ? MIDI_NOTE_ON : MIDI_NOTE_OFF;
+        event.value = data2 / 127.0f;
+        return numBytes > 2;
+    case 0x80:
+        event.type = MIDI_NOTE_OFF;
+        event.value = data2 / 127.0f;
+        return numBytes > 2;
+    case 0xa0:
+        event.type = MIDI_AFTERTOUCH;
+        event.value = data2 / 127.0f;
+        return numBytes > 2;
+    case 0xd0:
+        event.type = MIDI_CHANNEL_PRESSURE;
+        event.note = 0;
+        event.value = data1 / 127.0f;
+        return true;
+    case 0xe0:
+        event.type = MIDI_PITCH_WHEEL;
+        event.note = 0;
+        event.value = (float)(data1 | (data2 << 7)) / int(0x3fff);
+        return numBytes > 2;
+    case 0xb0:
+        if (numBytes < 3) {
+            return false;
+        } else if (data1 == 64) {
+            event.type = MIDI_SUSTAIN_PEDAL;
+        } else if (data1 == 66) {
+            event.type = MIDI_SOSTENUTO_PEDAL;
+        } else if (data1 == 67) {
+            event.type = MIDI_SOFT_PEDAL;
+        } else {
+            return false;
+        }
+        event.note = 0;
+        event.value = data2 >= 64 ? 1.0f : 0.0f;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * RenderEngine::handleAudioFrame
+ *    Handles incoming audio samples / midi events. Called on the audio
+ *    thread, so this must never block or allocate: if the render thread
+ *    has fallen behind, data is dropped and counted instead.
+ */
+void
+RenderEngine::handleAudioFrame(double timestamp,                 // IN
+                               double sampleRate,                // IN
+                               juce::AudioBuffer<float>& buffer, // IN
+                               juce::MidiBuffer &midiBuffer)     // IN
+{
+    if (!audioRing.push(timestamp, sampleRate, buffer)) {
+        numOverruns++;
+    }
+
+    if (midiBuffer.isEmpty()) {
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    midiFifo.prepareToWrite(midiBuffer.getNumEvents(), start1, size1, start2, size2);
+
+    int numWritten = 0;
+    for (const auto metadata : midiBuffer) {
+        MidiEvent decoded;
+        if (!decodeMidiEvent(metadata.data, metadata.numBytes, decoded)) {
+            continue;
+        }
+
+        if (numWritten == size1 + size2) {
+            numMidiEventsDropped++;
+            continue;
+        }
+
+        // In seconds now, as the rate may have changed by the time it's applied
+        decoded.time = timestamp + metadata.samplePosition / sampleRate;
+        midiEventPool[numWritten < size1 ? start1 + numWritten
+                                         : start2 + numWritten - size1] = decoded;
+        numWritten++;
+    }
+
+    midiFifo.finishedWrite(numWritten);
+}
+
+/*
+ * RenderEngine::feedAudio
+ *    Offline counterpart of handleAudioFrame, called on the render
+ *    thread. Draining straight away means nothing is ever dropped,
+ *    however much audio is fed between frames.
+ */
+void
+RenderEngine::feedAudio(double timestamp,                 // IN
+                        double sampleRate,                // IN
+                        juce::AudioBuffer<float> &buffer, // IN
+                        juce::MidiBuffer &midiBuffer)     // IN
+{
+    jassert(!listeningToProcessor);
+
+    handleAudioFrame(timestamp, sampleRate, buffer, midiBuffer);
+    drainAudioRing();
+}
+
+bool
+RenderEngine::loadExtensions()
+{
+    const juce::String errorTitle = "Insufficient OpenGL version";
+
+    glGetActiveUniform = (PFNGLGETACTIVEUNIFORMPROC)
+	    juce::OpenGLHelpers::getExtensionFunction("glGetActiveUniform");
+	if (glGetActiveUniform == nullptr) {
+	    alertError(errorTitle, "Could not find glGetActiveUniform");
+	    return false;
+	}
+	
+	glDrawBuffers = (PFNGLDRAWBUFFERSPROC)
+	    juce::OpenGLHelpers::getExtensionFunction("glDrawBuffers");
+	if (glDrawBuffers == nullptr) {
+	    alertError(errorTitle, "Could not find glDrawBuffers");
+	    return false;
+	}
+
+    glGetActiveUniformsiv = (PFNGLGETACTIVEUNIFORMSIVPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGetActiveUniformsiv");
+    if (glGetActiveUniformsiv == nullptr) {
+        alertError(errorTitle, "Could not find glGetActiveUniformsiv");
+        return false;
+    }
+
+    glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGetUniformBlockIndex");
+    if (glGetUniformBlockIndex == nullptr) {
+        alertError(errorTitle, "Could not find glGetUniformBlockIndex");
+        return false;
+    }
+
+    glGetActiveUniformBlockiv = (PFNGLGETACTIVEUNIFORMBLOCKIVPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGetActiveUniformBlockiv");
+    if (glGetActiveUniformBlockiv == nullptr) {
+        alertError(errorTitle, "Could not find glGetActiveUniformBlockiv");
+        return false;
+    }
+
+    glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glUniformBlockBinding");
+    if (glUniformBlockBinding == nullptr) {
+        alertError(errorTitle, "Could not find glUniformBlockBinding");
+        return false;
+    }
+
+    glBindBufferBase = (PFNGLBINDBUFFERBASEPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glBindBufferBase");
+    if (glBindBufferBase == nullptr) {
+        alertError(errorTitle, "Could not find glBindBufferBase");
+        return false;
+    }
+
+    /*
+     * Optional: lets the driver compile and link off-thread so the
+     * render loop can poll for completion. The KHR and ARB extensions
+     * only differ in their suffixes; GL_COMPLETION_STATUS_KHR and _ARB
+     * are the same value.
+     */
+    {
+        const char *maxThreadsFunction = nullptr;
+        if (juce::OpenGLHelpers::isExtensionSupported("GL_KHR_parallel_shader_compile")) {
+            maxThreadsFunction = "glMaxShaderCompilerThreadsKHR";
+        } else if (juce::OpenGLHelpers::isExtensionSupported("GL_ARB_parallel_shader_compile")) {
+            maxThreadsFunction = "glMaxShaderCompilerThreadsARB";
+        }
+
+        parallelShaderCompile = maxThreadsFunction != nullptr;
+        if (parallelShaderCompile) {
+            PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreads =
+                (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)
+                juce::OpenGLHelpers::getExtensionFunction(maxThreadsFunction);
+            if (glMaxShaderCompilerThreads != nullptr) {
+                glMaxShaderCompilerThreads(0xFFFFFFFF); // Driver's choice
+            }
+        }
+    }
+
+    /*
+     * Optional: program binaries for the on-disk cache (GL 4.1 /
+     * GL_ARB_get_program_binary).
+     */
+    glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGetProgramBinary");
+    glProgramBinary = (PFNGLPROGRAMBINARYPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glProgramBinary");
+    glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glProgramParameteri");
+
+    programCacheEnabled = false;
+    if (glGetProgramBinary != nullptr && glProgramBinary != nullptr &&
+        glProgramParameteri != nullptr) {
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        programCacheEnabled = numFormats > 0;
+    }
+
+    // Without it, mipmapped buffers are simply sampled at level 0
+    glGenerateMipmap = (PFNGLGENERATEMIPMAPPROC)
+        juce::OpenGLHelpers::getExtensionFunction("glGenerateMipmap");
+
+    programCache.setDriverId(juce::String((const char *)glGetString(GL_VENDOR)) + "\n" +
+                             juce::String((const char *)glGetString(GL_RENDERER)) + "\n" +
+                             juce::String((const char *)glGetString(GL_VERSION)));
+	
+	return true;
+}
+
+bool
+RenderEngine::checkIntrinsicUniform(const juce::String &name, // IN
+                                    GLenum type,              // IN
+                                    GLint size,               // IN
+                                    bool &isIntrinsic,        // OUT
+                                    int programIdx)           // IN
+{
+    ProgramData &program = programData[programIdx];
+    juce::String failReason;
+    isIntrinsic = false;
+
+    struct Intrinsic {
+        const char *name;
+        GLenum type;
+        GLint sizeMin;
+        GLint sizeMax;
+        TrackedUniform &tracked;
+    };
+
+    const Intrinsic intrinsics[] = {
+        { "iResolution", GL_FLOAT_VEC2, 1, 1, program.outputResolutionIntrinsic },
+        { "iKeyDown[0]", GL_FLOAT, MIDI_NUM_KEYS, MIDI_NUM_KEYS, program.keyDownIntrinsic },
+        { "iKeyUp[0]", GL_FLOAT, MIDI_NUM_KEYS, MIDI_NUM_KEYS, program.keyUpIntrinsic },
+        { "iKeyDownVelocity[0]", GL_FLOAT, MIDI_NUM_KEYS, MIDI_NUM_KEYS, program.keyDownVelocityIntrinsic },
+        { "iKeyUpVelocity[0]", GL_FLOAT, MIDI_NUM_KEYS, MIDI_NUM_KEYS, program.keyUpVelocityIntrinsic },
+        { "iAfterTouch[0]", GL_FLOAT, MIDI_NUM_KEYS, MIDI_NUM_KEYS, program.afterTouchIntrinsic },
+        { "iPitchWheel", GL_FLOAT, 1, 1, program.pitchWheelIntrinsic },
+        { "iSustainPedal", GL_FLOAT, 1, 1, program.sustainPedalIntrinsic },
+        { "iSostenutoPedal", GL_FLOAT, 1, 1, program.sostenutoPedalIntrinsic },
+        { "iSoftPedal", GL_FLOAT, 1, 1, program.softPedalIntrinsic },
+        { "iChannelPressure", GL_FLOAT, 1, 1, program.channelPressureIntrinsic },
+        { "iTime", GL_FLOAT, 1, 1, program.timeIntrinsic },
+        { "iSampleRate", GL_FLOAT, 1, 1, program.sampleRateIntrinsic },
+        { "iAudioChannel0[0]", GL_FLOAT, 16, MAX_AUDIO_CHANNEL_SIZE, program.audioChannel0 },
+        { "iAudioChannel1[0]", GL_FLOAT, 16, MAX_AUDIO_CHANNEL_SIZE, program.audioChannel1 }
+    };
+
+    for (int i = 0; i < sizeof(intrinsics) / sizeof(intrinsics[0]); i++) {
+        if (name == intrinsics[i].name) {
+            if (type != intrinsics[i].type) {
+                failReason = "Incorrect type";
+                goto failure;
+            }
+            
+            if (size < intrinsics[i].sizeMin || size > intrinsics[i].sizeMax) {
+                failReason = "Incorrect size";
+                goto failure;
+            }
+
+            intrinsics[i].tracked.uploaded.clear();
+            intrinsics[i].tracked.uniform = std::move(std::unique_ptr<juce::OpenGLShaderProgram::Uniform>
+                (new juce::OpenGLShaderProgram::Uniform(*program.program, intrinsics[i].name)));
+
+            if (name == "iAudioChannel0[0]") {
+                program.sizeAudioChannel0 = size;
+                maxSizeAudioChannel0 = juce::jmax(maxSizeAudioChannel0, size);
+            } else if (name == "iAudioChannel1[0]") {
+                program.sizeAudioChannel1 = size;
+                maxSizeAudioChannel1 = juce::jmax(maxSizeAudioChannel1, size);
+            }
+
+            isIntrinsic = true;
+            return true;
+        }
+    }
+
+    /*
+     * iBuffer<Name> / iResolutionBuffer<Name>, and iBuffer<Name><n> for
+     * color attachment n of a multiple render target buffer. A buffer
+     * whose full name matches wins over the attachment reading.
+     */
+    if (name.startsWith("iBuffer") || name.startsWith("iResolutionBuffer")) {
+        const bool isSampler = name.startsWith("iBuffer");
+        juce::String bufferName = name.fromFirstOccurrenceOf("Buffer", false, false);
+        int bufferIdx = processor.findBuffer(bufferName);
+        int attachment = 0;
+        std::vector<BufferUniform> &uniforms = isSampler ? program.bufferSamplers
+                                                         : program.bufferResolutions;
+
+        if (bufferIdx < 0 && isSampler && bufferName.length() > 1) {
+            int n = bufferName.getLastCharacter() - '0';
+            if (n >= 1 && n < ShadertoyAudioProcessor::MAX_RENDER_TARGETS) {
+                bufferIdx = processor.findBuffer(bufferName.dropLastCharacters(1));
+                attachment = n;
+            }
+        }
+
+        if (bufferIdx < 0 || bufferIdx >= (int)mAuxFramebuffers.size()) {
+            failReason = "No buffer named \"" + bufferName + "\"";
+            goto failure;
+        }
+
+        if (type != (isSampler ? GL_SAMPLER_2D : GL_FLOAT_VEC2)) {
+            failReason = "Incorrect type";
+            goto failure;
+        }
+
+        if (size != 1) {
+            failReason = "Incorrect size";
+            goto failure;
+        }
+
+        if (isSampler && uniforms.size() >= GLStateCache::MAX_TEXTURE_UNITS) {
+            failReason = "Too many buffer samplers";
+            goto failure;
+        }
+
+        uniforms.emplace_back();
+        uniforms.back().bufferIdx = bufferIdx;
+        uniforms.back().attachment = attachment;
+        uniforms.back().textureUnit = isSampler ? (GLint)uniforms.size() - 1 : 0;
+        uniforms.back().tracked.uniform.reset(
+            new juce::OpenGLShaderProgram::Uniform(*program.program, name.toRawUTF8()));
+
+        isIntrinsic = true;
+        return true;
+    }
+    
+    return true;
+    
+failure:
+    alertError("Error reading uniforms for program " + std::to_string(programIdx),
+               "Illegal use of intrinsic uniform name \"" + name + "\", reason: " + failReason);
+    return false;
+}
+
+/*
+ * RenderEngine::checkIntrinsicsBlock
+ *    If the program declares the ShadertoyIntrinsics uniform block,
+ *    verifies its size and binds it to the shared uniform buffer.
+ */
+bool
+RenderEngine::checkIntrinsicsBlock(int programIdx) // IN
+{
+    static_assert(sizeof(IntrinsicsBlock) == 10320, "IntrinsicsBlock must follow std140 layout");
+
+    ProgramData &program = programData[programIdx];
+    GLuint programID = program.program->getProgramID();
+
+    GLuint blockIdx = glGetUniformBlockIndex(programID, "ShadertoyIntrinsics");
+    if (blockIdx == GL_INVALID_INDEX) {
+        program.usesIntrinsicsBlock = false;
+        return true;
+    }
+
+    GLint dataSize = 0;
+    glGetActiveUniformBlockiv(programID, blockIdx, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    if (dataSize != (GLint)sizeof(IntrinsicsBlock)) {
+        alertError("Error reading uniforms for program " + std::to_string(programIdx),
+                   "ShadertoyIntrinsics block has size " + std::to_string(dataSize) +
+                   ", expected " + std::to_string(sizeof(IntrinsicsBlock)) +
+                   ". Declare it with layout(std140) exactly as documented.");
+        return false;
+    }
+
+    glUniformBlockBinding(programID, blockIdx, INTRINSICS_BLOCK_BINDING);
+    program.usesIntrinsicsBlock = true;
+    return true;
+}
+
+/*
+ * RenderEngine::checkIntrinsicsBlockMember
+ *    Verifies that a member of a uniform block is a ShadertoyIntrinsics
+ *    member sitting at the offset IntrinsicsBlock expects.
+ */
+bool
+RenderEngine::checkIntrinsicsBlockMember(const juce::String &name, // IN
+                                         GLuint uniformIdx,        // IN
+                                         int programIdx)           // IN
+{
+    ProgramData &program = programData[programIdx];
+    GLuint programID = program.program->getProgramID();
+    juce::String failReason;
+
+    struct Member {
+        const char *name;
+        size_t offset;
+    };
+
+    const Member members[] = {
+        { "iResolution", offsetof(IntrinsicsBlock, resolution) },
+        { "iResolutionBufferA", offsetof(IntrinsicsBlock, resolutionBuffer[0]) },
+        { "iResolutionBufferB", offsetof(IntrinsicsBlock, resolutionBuffer[1]) },
+        { "iResolutionBufferC", offsetof(IntrinsicsBlock, resolutionBuffer[2]) },
+        { "iResolutionBufferD", offsetof(IntrinsicsBlock, resolutionBuffer[3]) },
+        { "iTime", offsetof(IntrinsicsBlock, time) },
+        { "iSampleRate", offsetof(IntrinsicsBlock, sampleRate) },
+        { "iPitchWheel", offsetof(IntrinsicsBlock, pitchWheel) },
+        { "iSustainPedal", offsetof(IntrinsicsBlock, sustainPedal) },
+        { "iSostenutoPedal", offsetof(IntrinsicsBlock, sostenutoPedal) },
+        { "iSoftPedal", offsetof(IntrinsicsBlock, softPedal) },
+        { "iChannelPressure", offsetof(IntrinsicsBlock, channelPressure) },
+        { "iKeyDown[0]", offsetof(IntrinsicsBlock, keyDown) },
+        { "iKeyUp[0]", offsetof(IntrinsicsBlock, keyUp) },
+        { "iKeyDownVelocity[0]", offsetof(IntrinsicsBlock, keyDownVelocity) },
+        { "iKeyUpVelocity[0]", offsetof(IntrinsicsBlock, keyUpVelocity) },
+        { "iAfterTouch[0]", offsetof(IntrinsicsBlock, afterTouch) }
+    };
+
+    GLint blockIdx = -1;
+    GLint offset = -1;
+    glGetActiveUniformsiv(programID, 1, &uniformIdx, GL_UNIFORM_BLOCK_INDEX, &blockIdx);
+    glGetActiveUniformsiv(programID, 1, &uniformIdx, GL_UNIFORM_OFFSET, &offset);
+
+    // Members may be qualified by an instance name
+    juce::String memberName = name.fromLastOccurrenceOf("ShadertoyIntrinsics.", false, false);
+
+    if (!program.usesIntrinsicsBlock ||
+        (GLuint)blockIdx != glGetUniformBlockIndex(programID, "ShadertoyIntrinsics")) {
+        failReason = "Only the ShadertoyIntrinsics uniform block is supported";
+        goto failure;
+    }
+
+    for (int i = 0; i < sizeof(members) / sizeof(members[0]); i++) {
+        if (memberName == members[i].name) {
+            if ((size_t)offset != members[i].offset) {
+                failReason = "Member is out of order";
+                goto failure;
+            }
+            return true;
+        }
+    }
+
+    failReason = "Unknown member";
+
+failure:
+    alertError("Error reading uniforms for program " + std::to_string(programIdx),
+               "Illegal uniform block member \"" + name + "\", reason: " + failReason);
+    return false;
+}
+
+bool isDigit(const juce::String &str)
+{
+    for (int i = 0; i < str.length(); i++) {
+        if (str[i] < '0' || str[i] > '9') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * RenderEngine::startProgramBuild
+ *    Queues program idx to be (re)built from the processor's current
+ *    source. Whatever program is live keeps rendering until the new one
+ *    has linked successfully.
+ */
+void
+RenderEngine::startProgramBuild(int idx,                  // IN
+                                const juce::String &source) // IN
+{
+    discardProgramBuild(idx);
+    pendingPrograms[idx].queued = true;
+    pendingPrograms[idx].source = source;
+}
+
+/*
+ * RenderEngine::shaderReloaded
+ *    Called on the message thread when a shader's source changes on
+ *    disk. The source is captured here and rebuilt on the render thread;
+ *    nothing else in the renderer is reset.
+ */
+void
+RenderEngine::shaderReloaded(int idx) // IN
+{
+    const juce::SpinLock::ScopedLockType lock(shaderReloadLock);
+    shaderReloads.push_back({ idx, processor.getShaderString(idx) });
+}
+
+/*
+ * RenderEngine::issueProgramBuild
+ *    Hands the sources to the driver, or to shaderCompiler, and requests
+ *    a link without asking for any status, which is what would block.
+ */
+void
+RenderEngine::issueProgramBuild(int idx) // IN
+{
+    PendingProgram &pending = pendingPrograms[idx];
+    const GLchar *vertexSource = vert;
+    const GLchar *fragmentSourcePtr = pending.source.toRawUTF8();
+
+    pending.program.reset(new juce::OpenGLShaderProgram(glContext));
+    GLuint programID = pending.program->getProgramID();
+    pending.queued = false;
+    pending.issued = true;
+
+    if (programCacheEnabled) {
+        pending.cacheKey = programCache.makeKey(vertexSource, fragmentSourcePtr);
+        if (loadCachedProgram(idx)) {
+            return;
+        }
+    }
+
+    if (shaderCompiler.isRunning()) {
+        // Gets the new program object over to the worker's context
+        glFlush();
+        shaderCompiler.submitBuild(idx, programID, vert, pending.source, programCacheEnabled);
+        pending.onCompiler = true;
+        return;
+    }
+
+    if (programCacheEnabled) {
+        glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    pending.vertexShader = glContext.extensions.glCreateShader(GL_VERTEX_SHADER);
+    glContext.extensions.glShaderSource(pending.vertexShader, 1, &vertexSource, nullptr);
+    glContext.extensions.glCompileShader(pending.vertexShader);
+
+    pending.fragmentShader = glContext.extensions.glCreateShader(GL_FRAGMENT_SHADER);
+    glContext.extensions.glShaderSource(pending.fragmentShader, 1, &fragmentSourcePtr, nullptr);
+    glContext.extensions.glCompileShader(pending.fragmentShader);
+
+    glContext.extensions.glAttachShader(programID, pending.vertexShader);
+    glContext.extensions.glAttachShader(programID, pending.fragmentShader);
+    glContext.extensions.glLinkProgram(programID);
+}
+
+/*
+ * RenderEngine::isProgramBuildComplete
+ *    Returns true once querying the link status won't stall. With
+ *    neither parallel compilation nor shaderCompiler we can't tell, so
+ *    the caller limits itself to one blocking build per frame instead.
+ */
+bool
+RenderEngine::isProgramBuildComplete(int idx) // IN
+{
+    PendingProgram &pending = pendingPrograms[idx];
+
+    if (pending.onCompiler) {
+        if (!shaderCompiler.takeBuild(idx, pending.vertexShader, pending.fragmentShader)) {
+            return false;
+        }
+        pending.onCompiler = false;
+        return true;
+    }
+
+    if (!parallelShaderCompile || pending.fromCache) {
+        return true;
+    }
+
+    GLint complete = GL_FALSE;
+    glContext.extensions.glGetProgramiv(pending.program->getProgramID(),
+                                        GL_COMPLETION_STATUS_KHR, &complete);
+    return complete != GL_FALSE;
+}
+
+/*
+ * RenderEngine::finishProgramBuild
+ *    Checks a completed build for errors and, if it is usable, swaps it
+ *    in for the program currently at idx. Only programData[idx] is
+ *    touched; other programs, framebuffers and audio history are left
+ *    alone.
+ */
+void
+RenderEngine::finishProgramBuild(int idx) // IN
+{
+    PendingProgram &pending = pendingPrograms[idx];
+    GLuint programID = pending.program->getProgramID();
+    juce::String log;
+    GLint status = GL_FALSE;
+
+    if (!pending.fromCache &&
+        (!checkShaderCompiled(pending.vertexShader, "vertex", log) ||
+         !checkShaderCompiled(pending.fragmentShader, "fragment", log))) {
+        goto failure;
+    }
+
+    glContext.extensions.glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        GLchar infoLog[1024];
+        GLsizei infoLogLength = 0;
+        glContext.extensions.glGetProgramInfoLog(programID, sizeof(infoLog),
+                                                 &infoLogLength, infoLog);
+        log = juce::String(infoLog, (size_t)infoLogLength);
+        goto failure;
+    }
+
+    if (programCacheEnabled && !pending.fromCache) {
+        storeCachedProgram(idx);
+    }
+
+    {
+        std::unique_ptr<juce::OpenGLShaderProgram> program = std::move(pending.program);
+        discardProgramBuild(idx);
+
+        ProgramData previous = std::move(programData[idx]);
+        programData[idx] = ProgramData();
+        programData[idx].program = std::move(program);
+
+        if (!reflectShaderProgram(idx)) {
+            programData[idx].program->release();
+            programData[idx] = std::move(previous);
+            return;
+        }
+
+        if (previous.program != nullptr) {
+            previous.program->release();
+        }
+    }
+
+    if (programData[idx].usesIntrinsicsBlock && intrinsicsBuffer == 0) {
+        glContext.extensions.glGenBuffers(1, &intrinsicsBuffer);
+        glContext.extensions.glBindBuffer(GL_UNIFORM_BUFFER, intrinsicsBuffer);
+        glContext.extensions.glBufferData(GL_UNIFORM_BUFFER, sizeof(IntrinsicsBlock),
+                                          nullptr, GL_STREAM_DRAW);
+        intrinsicsBlockUploaded = false;
+    }
+
+    /*
+     * The new program may want a longer audio window than the history
+     * holds. If no audio has arrived yet, drainAudioRing sizes it.
+     */
+    if (firstAudioTimestamp >= 0.0) {
+        growAudioHistory(audioChannel0, maxSizeAudioChannel0);
+        growAudioHistory(audioChannel1, maxSizeAudioChannel1);
+    }
+
+    return;
+
+failure:
+    discardProgramBuild(idx);
+    alertError("Error building program " + std::to_string(idx), log);
+}
+
+void
+RenderEngine::discardProgramBuild(int idx) // IN
+{
+    PendingProgram &pending = pendingPrograms[idx];
+
+    if (pending.onCompiler) {
+        shaderCompiler.cancelBuild(idx, pending.vertexShader, pending.fragmentShader);
+    }
+
+    if (pending.vertexShader != 0) {
+        glContext.extensions.glDeleteShader(pending.vertexShader);
+    }
+
+    if (pending.fragmentShader != 0) {
+        glContext.extensions.glDeleteShader(pending.fragmentShader);
+    }
+
+    if (pending.program != nullptr) {
+        pending.program->release();
+    }
+
+    pendingPrograms[idx] = PendingProgram();
+}
+
+/*
+ * RenderEngine::pollProgramBuilds
+ *    Called once per frame. With parallel compilation, or shaderCompiler,
+ *    every queued build is issued immediately and picked up once it is
+ *    done; otherwise builds are done one per frame so a large patch
+ *    fills in progressively instead of stalling the first frame.
+ */
+void
+RenderEngine::pollProgramBuilds()
+{
+    std::vector<ShaderReload> reloads;
+    {
+        const juce::SpinLock::ScopedLockType lock(shaderReloadLock);
+        reloads.swap(shaderReloads);
+    }
+
+    for (auto &reload : reloads) {
+        // Shaders added since the context was created aren't built until it's recreated
+        if (reload.idx < (int)pendingPrograms.size()) {
+            startProgramBuild(reload.idx, reload.source);
+        }
+    }
+
+    for (int i = 0; i < (int)pendingPrograms.size(); i++) {
+        PendingProgram &pending = pendingPrograms[i];
+
+        if (pending.queued) {
+            issueProgramBuild(i);
+            if (!parallelShaderCompile && !shaderCompiler.isRunning()) {
+                finishProgramBuild(i);
+                return;
+            }
+        } else if (pending.issued && isProgramBuildComplete(i)) {
+            finishProgramBuild(i);
+        }
+    }
+}
+
+/*
+ * RenderEngine::finishProgramBuilds
+ *    Completes every build in flight right away, blocking on the driver
+ *    if need be. Offline rendering calls this before its first frame so
+ *    no frame is rendered with a pass still missing.
+ */
+void
+RenderEngine::finishProgramBuilds()
+{
+    // Everything is issued first, so builds can overlap
+    for (int i = 0; i < (int)pendingPrograms.size(); i++) {
+        if (pendingPrograms[i].queued) {
+            issueProgramBuild(i);
+        }
+    }
+
+    for (int i = 0; i < (int)pendingPrograms.size(); i++) {
+        PendingProgram &pending = pendingPrograms[i];
+
+        if (pending.onCompiler) {
+            shaderCompiler.waitForBuild(i, pending.vertexShader, pending.fragmentShader);
+            pending.onCompiler = false;
+        }
+
+        if (pending.issued) {
+            finishProgramBuild(i);
+        }
+    }
+}
+
+/*
+ * RenderEngine::loadCachedProgram
+ *    Tries to initialize the pending program from a cached binary.
+ *    Drivers may reject binaries at any time (e.g. after an update that
+ *    kept the version string), in which case the entry is dropped and
+ *    the caller compiles from source.
+ */
+bool
+RenderEngine::loadCachedProgram(int idx) // IN
+{
+    PendingProgram &pending = pendingPrograms[idx];
+    GLuint programID = pending.program->getProgramID();
+    juce::MemoryBlock binary;
+    GLenum format;
+
+    if (!programCache.load(pending.cacheKey, format, binary)) {
+        return false;
+    }
+
+    glProgramBinary(programID, format, binary.getData(), (GLsizei)binary.getSize());
+
+    GLint status = GL_FALSE;
+    glContext.extensions.glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        // The program object can still be built from source
+        programCache.remove(pending.cacheKey);
+        return false;
+    }
+
+    pending.fromCache = true;
+    return true;
+}
+
+void
+RenderEngine::storeCachedProgram(int idx) // IN
+{
+    PendingProgram &pending = pendingPrograms[idx];
+    GLuint programID = pending.program->getProgramID();
+
+    GLint length = 0;
+    glContext.extensions.glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    juce::MemoryBlock binary((size_t)length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(programID, length, &written, &format, binary.getData());
+    if (written > 0) {
+        programCache.store(pending.cacheKey, format, binary.getData(), (size_t)written);
+    }
+}
+
+bool
+RenderEngine::checkShaderCompiled(GLuint shader,          // IN
+                                  const char *stage,      // IN
+                                  juce::String &log)      // OUT
+{
+    GLint status = GL_FALSE;
+    glContext.extensions.glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_FALSE) {
+        return true;
+    }
+
+    GLchar infoLog[1024];
+    GLsizei infoLogLength = 0;
+    glContext.extensions.glGetShaderInfoLog(shader, sizeof(infoLog),
+                                            &infoLogLength, infoLog);
+    log = juce::String("Error compiling ") + stage + " shader:\n" +
+          juce::String(infoLog, (size_t)infoLogLength);
+    return false;
+}
+
+/*
+ * RenderEngine::reflectShaderProgram
+ *    Walks the active uniforms of a freshly linked program, hooking up
+ *    intrinsics and parameter uniforms and rejecting anything unknown.
+ */
+bool
+RenderEngine::reflectShaderProgram(int idx) // IN
+{
+    ProgramData &program = programData[idx];
+    juce::String message;
+
+	if (!checkIntrinsicsBlock(idx)) {
+	    return false;
+	}
+
+	GLint count;
+	glContext.extensions.glGetProgramiv(program.program->getProgramID(), GL_ACTIVE_UNIFORMS, &count);
+	
+	GLchar name[256];
+	GLsizei length;
+	GLint size;
+	GLenum type;
+	for (GLint i = 0; i < count; i++) {
+	    glGetActiveUniform(program.program->getProgramID(), (GLuint)i,
+	                       juce::numElementsInArray(name), &length, &size, &type, name);
+	    name[length] = '\0';
+
+	    const juce::String nameStr = name;
+
+	    GLuint uniformIdx = (GLuint)i;
+	    GLint blockIdx = -1;
+	    glGetActiveUniformsiv(program.program->getProgramID(), 1, &uniformIdx,
+	                          GL_UNIFORM_BLOCK_INDEX, &blockIdx);
+	    if (blockIdx != -1) {
+	        if (!checkIntrinsicsBlockMember(nameStr, uniformIdx, idx)) {
+	            return false;
+	        }
+	        continue;
+	    }
+
+	    bool isIntrinsic;
+	    if (!checkIntrinsicUniform(nameStr, type, size, isIntrinsic, idx)) {
+	        return false;
+	    }
+	    
+	    if (!isIntrinsic) {
+            int uniformIdx = 0;
+
+            if (size != 1) {
+	            message = "Parameter uniform \"";
+	            message += name;
+	            message += "\" cannot be an array.";
+	            goto failure;
+	        }
+
+            if (type == GL_FLOAT) {
+                if (nameStr.substring(0, 5) != "float" ||
+                    !isDigit(nameStr.substring(5)) ||
+                    (uniformIdx = nameStr.substring(5).getIntValue()) < 0 ||
+                    uniformIdx > 255) {
+                    message = "Parameter uniform \"";
+                    message += name;
+                    message += "\" must be named float0..255";
+                    goto failure;
+                }
+
+                program.uniformFloats.push_back({ glContext.extensions.glGetUniformLocation(
+                    program.program->getProgramID(), name), uniformIdx, 0, false });
+            } else if (type == GL_INT) {
+                if (nameStr.substring(0, 3) != "int" ||
+                    !isDigit(nameStr.substring(3)) ||
+                    (uniformIdx = nameStr.substring(3).getIntValue()) < 0 ||
+                    uniformIdx > 255) {
+                    message = "Parameter uniform \"";
+                    message += name;
+                    message += "\" must be named int0..255";
+                    goto failure;
+                }
+
+                program.uniformInts.push_back({ glContext.extensions.glGetUniformLocation(
+                    program.program->getProgramID(), name), uniformIdx, 0, false });
+            } else {
+	            message = "Parameter uniform \"";
+	            message += name;
+	            message += "\" of unrecognized type.";
+	            goto failure;
+	        }
+	    }
+	}
+
+	/*
+	 * Keep the parameter tables in location order so the per-frame upload
+	 * walks them linearly.
+	 */
+	auto byLocation = [](const ParamUniform &a, const ParamUniform &b) {
+	    return a.location < b.location;
+	};
+	std::sort(program.uniformFloats.begin(), program.uniformFloats.end(), byLocation);
+	std::sort(program.uniformInts.begin(), program.uniformInts.end(), byLocation);
+	
+	return true;
+
+failure:
+    alertError("Error reading uniforms for program " + std::to_string(idx), message);
+    return false;
+}
+
+bool
+RenderEngine::createFramebuffer(Framebuffer &fbOut, // OUT
+                                int destinationId)  // IN
+{
+    // Figure out if we have to create one and how big it needs to be
+    bool shouldCreateBuffer = destinationId == 1; // The output always exists
+    fbOut.width = 640;
+    fbOut.height = 360;
+
+    for (int i = 0; i < processor.getNumShaderFiles(); i++) {
+        if (processor.getShaderDestination(i) == destinationId) {
+            if (!shouldCreateBuffer) {
+                fbOut.texture = processor.getShaderTexture(i);
+            }
+            shouldCreateBuffer = true;
+            if (processor.getShaderFixedSizeBuffer(i)) {
+                fbOut.width = juce::jmax(fbOut.width, processor.getShaderFixedSizeWidth(i));
+                fbOut.height = juce::jmax(fbOut.height, processor.getShaderFixedSizeHeight(i));
+            } else {
+                fbOut.width = juce::jmax(fbOut.width, processor.getVisualizationWidth());
+                fbOut.height = juce::jmax(fbOut.height, processor.getVisualizationHeight());
+            }
+        }
+    }
+    
+    if (!shouldCreateBuffer) {
+        return true;
+    }
+    
+    return allocateFramebuffer(fbOut, destinationId);
+}
+
+/*
+ * RenderEngine::allocateFramebuffer
+ *    Creates the render target(s) for fb at its current size and
+ *    texture settings. Aux buffers get a back target for ping-ponging
+ *    and up to MAX_RENDER_TARGETS color attachments; the output
+ *    framebuffer only ever has one.
+ */
+bool
+RenderEngine::allocateFramebuffer(Framebuffer &fb,   // IN / OUT
+                                  int destinationId) // IN
+{
+    fb.numTargets = destinationId == 1 ? 1 : fb.texture.numTargets;
+
+    if (!createRenderTarget(fb.framebufferObj, fb.textureObj, fb.numTargets,
+                            fb.width, fb.height, fb.texture)) {
+        return false;
+    }
+
+    if (destinationId != 1 &&
+        !createRenderTarget(fb.backFramebufferObj, fb.backTextureObj, fb.numTargets,
+                            fb.width, fb.height, fb.texture)) {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * RenderEngine::updateFramebufferTexture
+ *    Brings a framebuffer in line with the texture settings of the
+ *    shader currently rendering to it. Filter / wrap / mipmap changes
+ *    only touch sampler state; a format or target count change
+ *    reallocates the targets (losing their contents). If the new format can't be rendered to,
+ *    the buffer falls back to RGBA8 but remembers the request so the
+ *    error is only reported once.
+ */
+void
+RenderEngine::updateFramebufferTexture(Framebuffer &fb,   // IN / OUT
+                                       int destinationId) // IN
+{
+    int programIdx = findPassProgram(destinationId);
+    if (fb.framebufferObj == 0 || programIdx < 0) {
+        return;
+    }
+
+    const ShadertoyAudioProcessor::BufferTexture wanted = processor.getShaderTexture(programIdx);
+    bool changed = true;
+
+    if (wanted.format != fb.texture.format || wanted.numTargets != fb.texture.numTargets) {
+        Framebuffer replacement;
+        replacement.width = fb.width;
+        replacement.height = fb.height;
+        replacement.texture = wanted;
+        releaseFramebuffer(fb);
+        fb = replacement;
+
+        if (!allocateFramebuffer(fb, destinationId)) {
+            releaseFramebuffer(fb);
+            fb = replacement;
+            fb.texture.format = ShadertoyAudioProcessor::FORMAT_RGB8;
+            allocateFramebuffer(fb, destinationId);
+        }
+    } else if (wanted.filter != fb.texture.filter || wanted.wrap != fb.texture.wrap ||
+               wanted.mipmaps != fb.texture.mipmaps) {
+        for (int i = 0; i < fb.numTargets; i++) {
+            applyTextureParameters(fb.textureObj[i], wanted);
+            if (fb.backTextureObj[i] != 0) {
+                applyTextureParameters(fb.backTextureObj[i], wanted);
+            }
+        }
+    } else {
+        changed = false;
+    }
+
+    fb.texture = wanted;
+
+    // The levels must exist before the first pass samples them
+    if (changed) {
+        generateMipmaps(fb);
+    }
+}
+
+/*
+ * RenderEngine::updateFramebufferTextures
+ *    Runs at the top of each frame, before the state cache is
+ *    invalidated, since (re)allocation binds objects directly.
+ */
+void
+RenderEngine::updateFramebufferTextures()
+{
+    updateFramebufferTexture(mOutputFramebuffer, 1);
+
+    for (int i = 0; i < (int)mAuxFramebuffers.size(); i++) {
+        updateFramebufferTexture(mAuxFramebuffers[i], 2 + i);
+    }
+}
+
+void
+RenderEngine::generateMipmaps(const Framebuffer &fb) // IN
+{
+    if (fb.texture.mipmaps && glGenerateMipmap != nullptr) {
+        for (int i = 0; i < fb.numTargets; i++) {
+            glState.bindTexture(0, fb.textureObj[i]);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+    }
+}
+
+void
+RenderEngine::getTextureFormat(int format,            // IN
+                               GLint &internalFormat, // OUT
+                               GLenum &pixelFormat,   // OUT
+                               GLenum &type)          // OUT
+{
+    switch (format) {
+    case ShadertoyAudioProcessor::FORMAT_RGBA8:
+        internalFormat = GL_RGBA8;
+        pixelFormat = GL_RGBA;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    case ShadertoyAudioProcessor::FORMAT_R8:
+        internalFormat = GL_R8;
+        pixelFormat = GL_RED;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    case ShadertoyAudioProcessor::FORMAT_R16F:
+        internalFormat = GL_R16F;
+        pixelFormat = GL_RED;
+        type = GL_FLOAT;
+        break;
+    case ShadertoyAudioProcessor::FORMAT_RGBA16F:
+        internalFormat = GL_RGBA16F;
+        pixelFormat = GL_RGBA;
+        type = GL_FLOAT;
+        break;
+    case ShadertoyAudioProcessor::FORMAT_R32F:
+        internalFormat = GL_R32F;
+        pixelFormat = GL_RED;
+        type = GL_FLOAT;
+        break;
+    case ShadertoyAudioProcessor::FORMAT_RGBA32F:
+        internalFormat = GL_RGBA32F;
+        pixelFormat = GL_RGBA;
+        type = GL_FLOAT;
+        break;
+    default:
+        internalFormat = GL_RGB8;
+        pixelFormat = GL_RGB;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    }
+}
+
+/*
+ * RenderEngine::applyTextureParameters
+ *    Expects the texture to be bindable on the current unit outside the
+ *    state cache (context creation or the top of a frame).
+ */
+void
+RenderEngine::applyTextureParameters(GLuint textureObj,                                    // IN
+                                     const ShadertoyAudioProcessor::BufferTexture &texture) // IN
+{
+    const bool linear = texture.filter == ShadertoyAudioProcessor::FILTER_LINEAR;
+    const bool mipmaps = texture.mipmaps && glGenerateMipmap != nullptr;
+    GLint minFilter;
+    GLint wrap;
+
+    if (mipmaps) {
+        minFilter = linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST;
+    } else {
+        minFilter = linear ? GL_LINEAR : GL_NEAREST;
+    }
+
+    switch (texture.wrap) {
+    case ShadertoyAudioProcessor::WRAP_REPEAT:
+        wrap = GL_REPEAT;
+        break;
+    case ShadertoyAudioProcessor::WRAP_MIRROR:
+        wrap = GL_MIRRORED_REPEAT;
+        break;
+    default:
+        wrap = GL_CLAMP_TO_EDGE;
+        break;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, textureObj);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, linear ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+}
+
+/*
+ * RenderEngine::createRenderTarget
+ *    One framebuffer object with numTargets color textures (attachment
+ *    i is written by `layout(location = i) out`), cleared to black so a
+ *    feedback pass starts from a known state.
+ */
+bool
+RenderEngine::createRenderTarget(GLuint &framebufferObj,                                // OUT
+                                 GLuint *textureObjs,                                   // OUT
+                                 int numTargets,                                        // IN
+                                 int width,                                             // IN
+                                 int height,                                            // IN
+                                 const ShadertoyAudioProcessor::BufferTexture &texture) // IN
+{
+    GLint internalFormat;
+    GLenum pixelFormat;
+    GLenum type;
+    GLenum drawBuffers[ShadertoyAudioProcessor::MAX_RENDER_TARGETS];
+    getTextureFormat(texture.format, internalFormat, pixelFormat, type);
+
+    glContext.extensions.glGenFramebuffers(1, &framebufferObj);
+    glContext.extensions.glBindFramebuffer(GL_FRAMEBUFFER, framebufferObj);
+    glGenTextures(numTargets, textureObjs);
+
+    for (int i = 0; i < numTargets; i++) {
+        glBindTexture(GL_TEXTURE_2D, textureObjs[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, pixelFormat, type, 0);
+        applyTextureParameters(textureObjs[i], texture);
+        glContext.extensions.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                                                    GL_TEXTURE_2D, textureObjs[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+
+    // Draw buffer state belongs to the framebuffer object, so this is set once
+    glDrawBuffers(numTargets, drawBuffers);
+    
+    if (glContext.extensions.glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        alertError("Unable to construct framebuffer", "Failed to construct the framebuffer");
+        return false;
+    }
+
+    glViewport(0, 0, width, height);
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    return true;
+}
+
+void
+RenderEngine::releaseFramebuffer(Framebuffer &fb) // IN / OUT
+{
+    if (fb.framebufferObj != 0) {
+        glContext.extensions.glDeleteFramebuffers(1, &fb.framebufferObj);
+    }
+
+    if (fb.backFramebufferObj != 0) {
+        glContext.extensions.glDeleteFramebuffers(1, &fb.backFramebufferObj);
+    }
+
+    // Deleting a zero name is silently ignored
+    glDeleteTextures(ShadertoyAudioProcessor::MAX_RENDER_TARGETS, fb.textureObj);
+    glDeleteTextures(ShadertoyAudioProcessor::MAX_RENDER_TARGETS, fb.backTextureObj);
+
+    fb = Framebuffer();
+}
+
+/*
+ * RenderEngine::ensureOutputFramebuffer
+ *    The output framebuffer only ever grows, so resizing the window back
+ *    and forth doesn't reallocate. Runs outside the state cache, like
+ *    updateFramebufferTextures.
+ */
+bool
+RenderEngine::ensureOutputFramebuffer(int width,  // IN
+                                      int height) // IN
+{
+    if (width <= mOutputFramebuffer.width && height <= mOutputFramebuffer.height) {
+        return true;
+    }
+
+    Framebuffer replacement;
+    replacement.width = juce::jmax(width, mOutputFramebuffer.width);
+    replacement.height = juce::jmax(height, mOutputFramebuffer.height);
+    replacement.texture = mOutputFramebuffer.texture;
+    releaseFramebuffer(mOutputFramebuffer);
+    mOutputFramebuffer = replacement;
+
+    return allocateFramebuffer(mOutputFramebuffer, 1);
+}
+
+RenderEngine::Framebuffer &
+RenderEngine::destinationToFramebuffer(int destinationId) // IN
+{
+    if (destinationId == 1) {
+        return mOutputFramebuffer;
+    } else {
+        return mAuxFramebuffers[destinationId - 2];
+    }
+}
+
+void
+RenderEngine::alertError(const juce::String &title,   // IN
+                         const juce::String &message) // IN
+{
+    if (onError) {
+        onError(title, message);
+        return;
+    }
+
+    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+	                                       title, message);
+}
+
+void
+RenderEngine::logMessage(const juce::String &message) // IN
+{
+    if (onLogMessage) {
+        onLogMessage(message);
+    }
+}
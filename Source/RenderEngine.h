@@ -0,0 +1,583 @@
+/*
+  ==============================================================================
+
+    RenderEngine.h
+    Created: 16 Oct 2026 10:37:12pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "AudioRing.h"
+#include "GLStateCache.h"
+#include "ProgramCache.h"
+#include "PassTimer.h"
+#include "ResolutionScaler.h"
+#include "FrameProfiler.h"
+#include "ShaderCompiler.h"
+#include "glext.h"
+
+#define RENDER_ENGINE_LOG_FPS 0
+#define RENDER_ENGINE_LOG_OVERRUNS 0
+#define RENDER_ENGINE_LOG_UNIFORM_STATS 0
+#define RENDER_ENGINE_LOG_STATE_STATS 0
+
+/*
+ * RenderEngine
+ *    Renders the visualization: shader programs, framebuffers,
+ *    intrinsics and pass scheduling. It has no component or window of
+ *    its own; each frame ends up in the output texture, which the
+ *    caller presents (GLRenderer) or reads back. The context only has
+ *    to be current while initialise, renderFrame and release run, so a
+ *    headless context (HeadlessContext) works as well as the editor's.
+ *
+ *    glContext only supplies the extension function table, and doesn't
+ *    need to be attached to anything.
+ */
+class RenderEngine : public ShadertoyAudioProcessor::AudioListener,
+                     public ShadertoyAudioProcessor::StateListener
+{
+public:
+    RenderEngine(ShadertoyAudioProcessor &processor,
+                 juce::OpenGLContext &glContext);
+    ~RenderEngine() override;
+
+    /*
+     * Context must be current. initialise returns false (and reports
+     * why through onError) if the context can't run the visualization.
+     * Unless listenToProcessor is set, the engine gets no audio from the
+     * processor and the caller feeds it with feedAudio.
+     */
+    bool initialise(bool listenToProcessor = true);
+    void release();
+    bool isValid() const { return validState; }
+
+    /*
+     * Renders one frame of width x height pixels into the output
+     * texture. now is in seconds and only needs to be monotonic.
+     *
+     * If audioTimestamp >= 0 the frame shows the audio at exactly that
+     * time, instead of trailing the live audio clock by DELAY_LATENCY,
+     * and dynamic resolution is off. Together with feedAudio this makes
+     * every frame a function of the input alone (offline rendering).
+     * Audio must have been fed up to audioTimestamp, and by no more than
+     * DELAY_LATENCY past it.
+     */
+    void renderFrame(int width, int height, double now, double audioTimestamp = -1.0);
+
+    /*
+     * Blocks until every shader program queued so far is built, rather
+     * than letting passes fill in over the next frames.
+     */
+    void finishProgramBuilds();
+
+    /*
+     * Render thread, when not listening to the processor: queues a block
+     * of audio / midi and moves the audio into the history right away.
+     */
+    void feedAudio(double timestamp, double sampleRate,
+                   juce::AudioBuffer<float> &buffer,
+                   juce::MidiBuffer &midiBuffer);
+
+    /*
+     * Render thread. Parameter values to render with in place of the
+     * processor's live ones, normalised and in getParameters() order (a
+     * replayed capture), or null to go back to the live values. values
+     * may change between frames and must outlive the override.
+     */
+    void setParameterOverride(const std::vector<float> *values)
+      { parameterOverride = values; }
+
+    /*
+     * The output texture, valid after the first renderFrame. The frame
+     * occupies the lower-left outputWidth x outputHeight of it (less
+     * than the requested size for fixed size or scaled output, 0 when
+     * no shader renders to the output).
+     */
+    GLuint getOutputTexture() const { return mOutputFramebuffer.textureObj[0]; }
+    int getOutputTextureWidth() const { return mOutputFramebuffer.width; }
+    int getOutputTextureHeight() const { return mOutputFramebuffer.height; }
+    int getOutputWidth() const { return (int)frameIntrinsics.outputResolution[0]; }
+    int getOutputHeight() const { return (int)frameIntrinsics.outputResolution[1]; }
+    GLuint getOutputFramebuffer() const { return mOutputFramebuffer.framebufferObj; }
+
+    /*
+     * Called on the render thread. Without onError, errors are shown in
+     * an alert window; without onLogMessage, debug logging goes nowhere.
+     */
+    std::function<void(const juce::String &title, const juce::String &message)> onError;
+    std::function<void(const juce::String &message)> onLogMessage;
+
+    void handleAudioFrame(double timestamp, double sampleRate,
+                          juce::AudioBuffer<float>& buffer,
+                          juce::MidiBuffer &midiBuffer) override;
+
+    void processorStateChanged() override { }
+    void shaderReloaded(int idx) override;
+
+    /*
+     * Number of audio / midi blocks dropped on the audio thread because
+     * the render thread fell behind.
+     */
+    int getNumOverruns() const { return numOverruns.load(); }
+
+    /*
+     * Number of midi events dropped because the event pool was full.
+     */
+    int getNumMidiEventsDropped() const { return numMidiEventsDropped.load(); }
+
+    /*
+     * Number of uniforms (including the intrinsics block) sent to the
+     * driver vs. skipped as unchanged during the last frame.
+     */
+    int getNumUniformsUploaded() const { return numUniformsUploaded.load(); }
+    int getNumUniformsSkipped() const { return numUniformsSkipped.load(); }
+
+    /*
+     * Number of GL state changes (program, texture, framebuffer and
+     * viewport binds) issued vs. filtered as redundant during the last
+     * frame.
+     */
+    int getNumStateChangesIssued() const { return numStateChangesIssued.load(); }
+    int getNumStateChangesFiltered() const { return numStateChangesFiltered.load(); }
+
+    /*
+     * Per-frame CPU / GPU timing history (see FrameProfiler).
+     */
+    const FrameProfiler &getProfiler() const { return profiler; }
+    juce::String getPassName(int passId);
+
+private:
+    /*
+     * A uniform along with a shadow copy of the last value uploaded to
+     * it, stored as raw 32-bit words. Uploads of unchanged values are
+     * skipped.
+     */
+    struct TrackedUniform {
+        std::unique_ptr<juce::OpenGLShaderProgram::Uniform> uniform;
+        std::vector<juce::uint32> uploaded; // Empty until the first upload
+    };
+
+    /*
+     * A float0..255 / int0..255 parameter uniform. These live in flat
+     * arrays sorted by GL location and are uploaded with raw
+     * glUniform1f/1i calls, so the per-frame walk touches contiguous
+     * memory and no Uniform objects. The last uploaded value is kept as
+     * raw bits for change detection.
+     */
+    struct ParamUniform {
+        GLint location;
+        int paramIdx;
+        juce::uint32 uploaded;
+        bool hasUploaded;
+    };
+
+    /*
+     * An iBuffer<Name> sampler or iResolutionBuffer<Name> uniform,
+     * resolved to an aux buffer index at link time.
+     */
+    struct BufferUniform {
+        int bufferIdx;
+        int attachment;    // Samplers only, 0 unless iBuffer<Name><1..3>
+        GLint textureUnit; // Samplers only
+        TrackedUniform tracked;
+    };
+
+    struct ProgramData {
+        std::unique_ptr<juce::OpenGLShaderProgram> program;
+        std::vector<ParamUniform> uniformFloats;
+        std::vector<ParamUniform> uniformInts;
+        TrackedUniform outputResolutionIntrinsic;
+        std::vector<BufferUniform> bufferSamplers;
+        std::vector<BufferUniform> bufferResolutions;
+        TrackedUniform keyDownIntrinsic;
+        TrackedUniform keyUpIntrinsic;
+        TrackedUniform keyDownVelocityIntrinsic;
+        TrackedUniform keyUpVelocityIntrinsic;
+        TrackedUniform afterTouchIntrinsic;
+        TrackedUniform pitchWheelIntrinsic;
+        TrackedUniform sustainPedalIntrinsic;
+        TrackedUniform sostenutoPedalIntrinsic;
+        TrackedUniform softPedalIntrinsic;
+        TrackedUniform channelPressureIntrinsic;
+        TrackedUniform timeIntrinsic;
+        TrackedUniform sampleRateIntrinsic;
+        TrackedUniform audioChannel0;
+        GLint sizeAudioChannel0;
+        TrackedUniform audioChannel1;
+        GLint sizeAudioChannel1;
+        bool usesIntrinsicsBlock = false;
+    };
+
+    /*
+     * A program build in flight. Compilation and linking are issued
+     * without querying status; with GL_KHR/ARB_parallel_shader_compile
+     * the driver does the work on its own threads and we poll
+     * GL_COMPLETION_STATUS_KHR once per frame. Failing that the build
+     * goes to shaderCompiler, which hands the shaders back when done.
+     */
+    struct PendingProgram {
+        std::unique_ptr<juce::OpenGLShaderProgram> program;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        bool queued = false; // Waiting to be issued
+        bool issued = false; // Handed to the driver
+        bool fromCache = false; // Loaded with glProgramBinary, no shaders
+        bool onCompiler = false; // Submitted to shaderCompiler, not ours to touch
+        juce::uint64 cacheKey = 0;
+        juce::String source; // Fragment source captured when queued
+    };
+
+    /*
+     * A reloaded shader source handed from the message thread to the
+     * render thread.
+     */
+    struct ShaderReload {
+        int idx;
+        juce::String source;
+    };
+
+    /*
+     * A midi message, decoded once on the audio thread. Only the message
+     * types that feed an intrinsic are forwarded.
+     */
+    enum MidiEventType : juce::uint8 {
+        MIDI_NOTE_ON,
+        MIDI_NOTE_OFF,
+        MIDI_AFTERTOUCH,
+        MIDI_PITCH_WHEEL,
+        MIDI_SUSTAIN_PEDAL,
+        MIDI_SOSTENUTO_PEDAL,
+        MIDI_SOFT_PEDAL,
+        MIDI_CHANNEL_PRESSURE
+    };
+
+    struct MidiEvent {
+        double time;            // Seconds, on the audio timestamp clock
+        MidiEventType type;
+        juce::uint8 channel;    // 1..16
+        juce::uint8 note;
+        float value;            // Velocity / pressure / wheel / pedal, 0..1
+    };
+
+    /*
+     * Power-of-two circular history of one audio channel. Only the
+     * render thread touches it.
+     */
+    struct AudioHistory {
+        std::unique_ptr<float[]> samples;
+        juce::uint32 mask = 0;     // capacity - 1
+        juce::uint32 writePos = 0; // Free-running, wraps through mask
+    };
+
+    /*
+     * Aux buffers are double buffered: a pass renders into the back
+     * target, then the two are swapped, so textureObj always holds the
+     * last completed contents and a pass can sample its own previous
+     * frame. The output framebuffer has no back target.
+     */
+    struct Framebuffer {
+        GLuint framebufferObj = 0;
+        GLuint textureObj[ShadertoyAudioProcessor::MAX_RENDER_TARGETS] = { };
+        GLuint backFramebufferObj = 0;
+        GLuint backTextureObj[ShadertoyAudioProcessor::MAX_RENDER_TARGETS] = { };
+        int numTargets = 1;
+        int width = 640;
+        int height = 360;
+        ShadertoyAudioProcessor::BufferTexture texture; // As allocated
+    };
+
+    /*
+     * Per aux buffer update rate, from the shader rendering to it.
+     */
+    struct PassRate {
+        int divisor = 1;
+        double hz = 0.0;
+        int phase = 0;           // Renders when frameCount % divisor == phase
+        double nextUpdate = 0.0; // Hz mode
+    };
+
+    static void allocateAudioHistory(AudioHistory &history, int minSize);
+    static void advanceAudioHistory(AudioHistory &history, const float *src, int srcSize);
+    static void readAudioHistory(const AudioHistory &history, float *dst,
+                                 int size, int delay);
+    void growAudioHistory(AudioHistory &history, GLint maxSize);
+    void allocateAudioQueues();
+    void drainAudioRing();
+    void applyMidiEvents(double currentAudioTimestamp);
+    static bool decodeMidiEvent(const juce::uint8 *data, int numBytes,
+                                MidiEvent &event);
+    bool loadExtensions();
+    void startProgramBuild(int idx, const juce::String &source);
+    void issueProgramBuild(int idx);
+    bool isProgramBuildComplete(int idx);
+    void finishProgramBuild(int idx);
+    void discardProgramBuild(int idx);
+    void pollProgramBuilds();
+    bool checkShaderCompiled(GLuint shader, const char *stage, juce::String &log);
+    bool loadCachedProgram(int idx);
+    void storeCachedProgram(int idx);
+    bool reflectShaderProgram(int idx);
+    bool createFramebuffer(Framebuffer &fbOut,
+                           int destinationId);
+    bool allocateFramebuffer(Framebuffer &fb, int destinationId);
+    bool createRenderTarget(GLuint &framebufferObj, GLuint *textureObjs, int numTargets,
+                            int width, int height,
+                            const ShadertoyAudioProcessor::BufferTexture &texture);
+    void applyTextureParameters(GLuint textureObj,
+                                const ShadertoyAudioProcessor::BufferTexture &texture);
+    void updateFramebufferTexture(Framebuffer &fb, int destinationId);
+    void updateFramebufferTextures();
+    void generateMipmaps(const Framebuffer &fb);
+    static void getTextureFormat(int format, GLint &internalFormat,
+                                 GLenum &pixelFormat, GLenum &type);
+    void releaseFramebuffer(Framebuffer &fb);
+    bool checkIntrinsicUniform(const juce::String &name, GLenum type,
+                               GLint size, bool &isIntrinsic, int programIdx);
+    bool checkIntrinsicsBlock(int programIdx);
+    bool checkIntrinsicsBlockMember(const juce::String &name, GLuint uniformIdx,
+                                    int programIdx);
+    void updateIntrinsics(double currentAudioTimestamp,
+                          int width,
+                          int height);
+    void setProgramIntrinsics(int programIdx,
+                              double currentAudioTimestamp);
+    bool markUniformUploaded(TrackedUniform &tracked, const void *words, int numWords);
+    void setTrackedUniform(TrackedUniform &tracked, GLfloat value);
+    void setTrackedUniform(TrackedUniform &tracked, GLfloat x, GLfloat y);
+    void setTrackedUniform(TrackedUniform &tracked, GLint value);
+    void setTrackedUniform(TrackedUniform &tracked, const GLfloat *values, int count);
+    bool ensureOutputFramebuffer(int width, int height);
+    void setParamUniforms(ProgramData &program);
+    float getUniformFloat(int i);
+    int getUniformInt(int i);
+    int getOutputProgramIdx();
+    int getBufferProgramIdx(int bufferId);
+    int findPassProgram(int destinationId);
+    void schedulePasses();
+    void selectPassUpdates(double now);
+    void assignPassPhases(double now);
+    static GLfloat scaleDimension(int size, float scale);
+    void renderAuxBuffer(int bufferIdx,
+                         double currentAudioTimestamp);
+    void renderOutputBuffer(double currentAudioTimestamp);
+    Framebuffer &destinationToFramebuffer(int destinationId);
+    void alertError(const juce::String &title, const juce::String &message);
+    void logMessage(const juce::String &message);
+
+    /*
+     * Number of keys on a midi keyboard
+     */
+    static constexpr int MIDI_NUM_KEYS = 128;
+
+    /*
+     * Largest iAudioChannel0..1 array a shader may declare
+     */
+    static constexpr int MAX_AUDIO_CHANNEL_SIZE = 2048;
+
+    /*
+     * Uniform buffer binding point of the ShadertoyIntrinsics block
+     */
+    static constexpr GLuint INTRINSICS_BLOCK_BINDING = 0;
+
+    /*
+     * CPU-side mirror of the ShadertoyIntrinsics uniform block. The layout
+     * follows std140 rules, where every array element takes 16 bytes.
+     * Must match the declaration in Documentation/GETTINGSTARTED.md.
+     */
+    struct Std140Float {
+        GLfloat value;
+        GLfloat pad[3];
+    };
+
+    struct IntrinsicsBlock {
+        GLfloat resolution[2];
+        GLfloat resolutionBuffer[4][2];
+        GLfloat time;
+        GLfloat sampleRate;
+        GLfloat pitchWheel;
+        GLfloat sustainPedal;
+        GLfloat sostenutoPedal;
+        GLfloat softPedal;
+        GLfloat channelPressure;
+        GLfloat pad[3];
+        Std140Float keyDown[MIDI_NUM_KEYS];
+        Std140Float keyUp[MIDI_NUM_KEYS];
+        Std140Float keyDownVelocity[MIDI_NUM_KEYS];
+        Std140Float keyUpVelocity[MIDI_NUM_KEYS];
+        Std140Float afterTouch[MIDI_NUM_KEYS];
+    };
+
+    /*
+     * Intrinsic values for the current frame, converted once and shared
+     * by every pass that uses the loose (non-block) uniforms.
+     */
+    struct FrameIntrinsics {
+        GLfloat keyDown[MIDI_NUM_KEYS];
+        GLfloat keyUp[MIDI_NUM_KEYS];
+        GLfloat keyDownVelocity[MIDI_NUM_KEYS];
+        GLfloat keyUpVelocity[MIDI_NUM_KEYS];
+        GLfloat afterTouch[MIDI_NUM_KEYS];
+        GLfloat outputResolution[2];
+        GLfloat auxResolution[ShadertoyAudioProcessor::MAX_BUFFERS][2];
+    };
+
+    /*
+     * processBlock, and by extension handleAudioFrame, is called at irregular
+     * intervals. To smooth out input audio and midi, we introduce an artificial
+     * delay. As a result the sample position and midi timestamps provided to
+     * the shaders advance at a (roughly) constant pace between frames.
+     */
+    static constexpr double DELAY_LATENCY = 0.016;
+
+    /*
+     * Sizing of the queues between the audio and render threads. They are
+     * allocated from the sample rate / block size given to prepareToPlay
+     * and never grow: when full, data is dropped and counted.
+     */
+    static constexpr double AUDIO_QUEUE_SECONDS = 0.25; // Slack for a stalled render thread
+    static constexpr int MIN_AUDIO_QUEUE_BLOCKS = 16;
+    static constexpr int MIN_HOST_BLOCK_SIZE = 16;      // Hosts may split blocks this small
+    static constexpr int MIDI_EVENTS_PER_BLOCK = 64;
+
+    ShadertoyAudioProcessor& processor;
+    juce::OpenGLContext &glContext;
+    GLStateCache glState;
+    std::atomic<int> numStateChangesIssued { 0 };
+    std::atomic<int> numStateChangesFiltered { 0 };
+
+    /*
+     * Pass ids for timing and dynamic resolution: the output pass, then
+     * one per aux buffer.
+     */
+    static constexpr int OUTPUT_PASS_ID = 0;
+    static constexpr int AUX_PASS_ID_BASE = 1;
+    static_assert(AUX_PASS_ID_BASE + ShadertoyAudioProcessor::MAX_BUFFERS <= PassTimer::MAX_PASSES,
+                  "Every pass needs a timer slot");
+
+    PassTimer passTimer;
+    ResolutionScaler resolutionScaler;
+    FrameProfiler profiler;
+    juce::int64 frameUniformTicks = 0; // Render thread only
+
+    std::vector<PassRate> passRates;
+    juce::uint64 frameCount = 0;
+    static constexpr int MAX_PHASE_WINDOW = 720;
+  
+    std::vector<ProgramData> programData; // Null program until its first build completes
+
+    std::vector<PendingProgram> pendingPrograms;
+    bool parallelShaderCompile = false;
+    ShaderCompiler shaderCompiler; // Running only without parallelShaderCompile
+
+    juce::SpinLock shaderReloadLock; // Message thread <-> render thread only
+    std::vector<ShaderReload> shaderReloads;
+
+    ProgramCache programCache;
+    bool programCacheEnabled = false; // Driver supports at least one binary format
+
+    bool validState = true;
+    bool listeningToProcessor = false;
+    const std::vector<float> *parameterOverride = nullptr;
+    double mSampleRate = 44100.0;
+
+    Framebuffer mOutputFramebuffer; // Grows to the largest size rendered
+    std::vector<Framebuffer> mAuxFramebuffers; // One per processor buffer
+
+    /*
+     * This frame's aux passes, in dependency order. Only touched by the
+     * render thread.
+     */
+    std::vector<int> passOrder;
+
+    // Time stuff
+    double firstRender = -1.0;
+    double prevRender = -1.0;
+    double firstAudioTimestamp = -1.0;
+    double lastAudioTimestamp = -1.0;    // Start of the newest block
+    double lastAudioEndTimestamp = -1.0; // End of the newest block
+    int frameAudioDelay = 0; // Samples between the audio windows and the newest sample
+    double keyDownLast[MIDI_NUM_KEYS] = { };
+    double keyUpLast[MIDI_NUM_KEYS] = { };
+    float keyDownVelocity[MIDI_NUM_KEYS] = { };
+    float keyUpVelocity[MIDI_NUM_KEYS] = { };
+    float afterTouch[MIDI_NUM_KEYS] = { };
+    float pitchWheel = 0.0f;
+    float sustainPedal = 0.0f;
+    float sostenutoPedal = 0.0f;
+    float softPedal = 0.0f;
+    float channelPressure = 0.0f;
+
+    FrameIntrinsics frameIntrinsics = { };
+    IntrinsicsBlock intrinsicsBlock = { };
+    IntrinsicsBlock uploadedIntrinsicsBlock = { };
+    bool intrinsicsBlockUploaded = false;
+    GLuint intrinsicsBuffer = 0;
+
+    /*
+     * Uniform upload statistics. The frame counters are only touched by
+     * the render thread; the atomics hold the last completed frame.
+     */
+    int frameUniformsUploaded = 0;
+    int frameUniformsSkipped = 0;
+    std::atomic<int> numUniformsUploaded { 0 };
+    std::atomic<int> numUniformsSkipped { 0 };
+  
+    /*
+     * Audio history, owned by the render thread
+     */
+    AudioHistory audioChannel0;
+    GLint maxSizeAudioChannel0 = 0;
+    AudioHistory audioChannel1;
+    GLint maxSizeAudioChannel1 = 0;
+    float audioWindow[MAX_AUDIO_CHANNEL_SIZE] = { };
+
+    /*
+     * Lock-free hand-off from the audio thread. Both queues have a single
+     * producer (handleAudioFrame) and a single consumer (renderFrame).
+     */
+    AudioRing audioRing;
+    juce::AudioBuffer<float> audioRingScratch;
+    juce::AbstractFifo midiFifo { 1 };
+    std::vector<MidiEvent> midiEventPool;
+    std::atomic<int> numOverruns { 0 };
+    std::atomic<int> numMidiEventsDropped { 0 };
+    double audioQueueSampleRate = 0.0;
+    int audioQueueBlockSize = 0;
+
+#if RENDER_ENGINE_LOG_FPS == 1
+    double avgFPS = 0.0;
+    double lastFPSLog = 0.0;
+#endif
+
+#if RENDER_ENGINE_LOG_UNIFORM_STATS == 1
+    double lastUniformStatsLog = 0.0;
+#endif
+
+#if RENDER_ENGINE_LOG_STATE_STATS == 1
+    double lastStateStatsLog = 0.0;
+#endif
+
+#if RENDER_ENGINE_LOG_OVERRUNS == 1
+    int lastLoggedOverruns = 0;
+    int lastLoggedMidiEventsDropped = 0;
+#endif
+    
+    PFNGLGETACTIVEUNIFORMPROC glGetActiveUniform;
+    PFNGLDRAWBUFFERSPROC glDrawBuffers;
+    PFNGLGETACTIVEUNIFORMSIVPROC glGetActiveUniformsiv;
+    PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex;
+    PFNGLGETACTIVEUNIFORMBLOCKIVPROC glGetActiveUniformBlockiv;
+    PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding;
+    PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+    PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+    PFNGLPROGRAMBINARYPROC glProgramBinary;
+    PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+    PFNGLGENERATEMIPMAPPROC glGenerateMipmap;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderEngine)
+};
@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    ResolutionScaler.cpp
+    Created: 16 Oct 2026 8:31:52pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ResolutionScaler.h"
+#include <cmath>
+
+ResolutionScaler::ResolutionScaler()
+{
+    for (int i = 0; i < MAX_PASSES; i++) {
+        scalable[i] = true;
+    }
+
+    reset();
+}
+
+ResolutionScaler::~ResolutionScaler()
+{
+}
+
+void
+ResolutionScaler::setTarget(double targetFps, // IN
+                            float minScale,   // IN
+                            float maxScale)   // IN
+{
+    budget = BUDGET_FRACTION / juce::jmax(1.0, targetFps);
+    this->maxScale = juce::jlimit(0.05f, 1.0f, maxScale);
+    this->minScale = juce::jlimit(0.05f, this->maxScale, minScale);
+
+    for (int i = 0; i < MAX_PASSES; i++) {
+        scales[i] = juce::jlimit(this->minScale, this->maxScale, scales[i]);
+    }
+}
+
+void
+ResolutionScaler::reset()
+{
+    for (int i = 0; i < MAX_PASSES; i++) {
+        scales[i] = maxScale;
+        timeSums[i] = 0.0;
+        timeCounts[i] = 0;
+    }
+
+    framesSinceChange = 0;
+    numSampleFrames = 0;
+}
+
+void
+ResolutionScaler::update(const PassTimer &timer) // IN
+{
+    if (!timer.isAvailable()) {
+        return;
+    }
+
+    if (++framesSinceChange < SETTLE_FRAMES) {
+        return;
+    }
+
+    for (int i = 0; i < MAX_PASSES; i++) {
+        if (timer.hasPassTime(i)) {
+            timeSums[i] += timer.getPassTime(i);
+            timeCounts[i]++;
+        }
+    }
+
+    if (++numSampleFrames >= SAMPLE_FRAMES) {
+        adjust();
+
+        for (int i = 0; i < MAX_PASSES; i++) {
+            timeSums[i] = 0.0;
+            timeCounts[i] = 0;
+        }
+        numSampleFrames = 0;
+    }
+}
+
+/*
+ * ResolutionScaler::adjust
+ *    With c_i the estimated full-resolution cost of pass i, the
+ *    expensive passes get the common scale s solving
+ *        cheapTime + s^2 * sum(c_i) = SETTLE_TARGET * budget
+ *    and then each pass moves toward its goal by at most one step.
+ *    Passes that aren't scalable count toward cheapTime as they are.
+ */
+void
+ResolutionScaler::adjust()
+{
+    double averages[MAX_PASSES];
+    double costs[MAX_PASSES];
+    double total = 0.0;
+    double totalCost = 0.0;
+    double fixedTime = 0.0;
+
+    for (int i = 0; i < MAX_PASSES; i++) {
+        averages[i] = timeCounts[i] > 0 ? timeSums[i] / timeCounts[i] : 0.0;
+        total += averages[i];
+
+        if (!scalable[i]) {
+            costs[i] = 0.0;
+            fixedTime += averages[i];
+            continue;
+        }
+
+        costs[i] = averages[i] / ((double)scales[i] * scales[i]);
+        totalCost += costs[i];
+    }
+
+    const bool shrink = total > budget;
+    const bool grow = total < budget * GROW_THRESHOLD;
+    if ((!shrink && !grow) || totalCost <= 0.0) {
+        return;
+    }
+
+    // Degrading the scalable passes wouldn't bring the frame in budget
+    if (shrink && fixedTime >= budget * SETTLE_TARGET) {
+        return;
+    }
+
+    double cheapTime = fixedTime;
+    double expensiveCost = 0.0;
+    for (int i = 0; i < MAX_PASSES; i++) {
+        if (!scalable[i]) {
+            continue;
+        }
+
+        if (costs[i] < totalCost * CHEAP_PASS_SHARE) {
+            cheapTime += costs[i] * maxScale * maxScale;
+        } else {
+            expensiveCost += costs[i];
+        }
+    }
+
+    double available = juce::jmax(0.0, budget * SETTLE_TARGET - cheapTime);
+    float expensiveScale = expensiveCost > 0.0 ? (float)std::sqrt(available / expensiveCost)
+                                               : maxScale;
+    bool changed = false;
+
+    for (int i = 0; i < MAX_PASSES; i++) {
+        if (timeCounts[i] == 0 || !scalable[i]) {
+            continue;
+        }
+
+        float goal = costs[i] < totalCost * CHEAP_PASS_SHARE ? maxScale : expensiveScale;
+        float scale = juce::jlimit(scales[i] * MAX_SHRINK_STEP, scales[i] * MAX_GROW_STEP, goal);
+        scale = juce::jlimit(minScale, maxScale, scale);
+
+        // Never move against the direction of the correction
+        scale = shrink ? juce::jmin(scale, scales[i]) : juce::jmax(scale, scales[i]);
+
+        if (scale != scales[i]) {
+            scales[i] = scale;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        framesSinceChange = 0;
+    }
+}
+
+#if JUCE_UNIT_TESTS
+
+class ResolutionScalerTests : public juce::UnitTest
+{
+public:
+    ResolutionScalerTests() : juce::UnitTest("ResolutionScaler") { }
+
+    void runTest() override
+    {
+        beginTest("Fixed passes over budget leave the scalable ones alone");
+        {
+            ResolutionScaler scaler;
+            scaler.setTarget(60.0, 0.5f, 1.0f);
+            scaler.setScalable(1, false);
+
+            // 16 ms of a 15 ms budget in the fixed pass
+            for (int i = 0; i < 4; i++) {
+                sample(scaler, 0.002, 0.016);
+            }
+
+            expectEquals(scaler.getScale(0), 1.0f);
+            expectEquals(scaler.getScale(1), 1.0f);
+        }
+
+        beginTest("Fixed passes taking most of the budget shrink the others");
+        {
+            ResolutionScaler scaler;
+            scaler.setTarget(60.0, 0.5f, 1.0f);
+            scaler.setScalable(1, false);
+
+            // The output pass would have to go below the largest step to
+            // fit in what the fixed pass leaves of the settle target
+            sample(scaler, 0.008, 0.010);
+            expectEquals(scaler.getScale(0), ResolutionScaler::MAX_SHRINK_STEP);
+            expectEquals(scaler.getScale(1), 1.0f);
+
+            sample(scaler, 0.008 * 0.75 * 0.75, 0.011);
+            expectEquals(scaler.getScale(0), 0.5625f);
+        }
+    }
+
+private:
+    /*
+     * Runs one adjustment as if the timer had measured output (pass 0)
+     * and aux (pass 1) over every sample frame.
+     */
+    void
+    sample(ResolutionScaler &scaler, // IN / OUT
+           double output,            // IN
+           double aux)               // IN
+    {
+        for (int i = 0; i < ResolutionScaler::MAX_PASSES; i++) {
+            scaler.timeSums[i] = 0.0;
+            scaler.timeCounts[i] = 0;
+        }
+
+        scaler.timeSums[0] = output;
+        scaler.timeCounts[0] = 1;
+        scaler.timeSums[1] = aux;
+        scaler.timeCounts[1] = 1;
+        scaler.adjust();
+    }
+};
+
+static ResolutionScalerTests resolutionScalerTests;
+
+#endif // JUCE_UNIT_TESTS
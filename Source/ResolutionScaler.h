@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    ResolutionScaler.h
+    Created: 16 Oct 2026 8:31:52pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PassTimer.h"
+
+/*
+ * ResolutionScaler
+ *    Chooses a render scale per pass so the summed GPU time of all
+ *    passes fits a frame-time budget. Pass cost is modeled as
+ *    proportional to pixel count (scale squared). Passes that are cheap
+ *    at full resolution are left alone and the expensive ones share the
+ *    reduction, since scaling a cheap pass saves little and costs
+ *    quality. Changes only happen when time leaves a hysteresis band
+ *    around the budget, and each step is rate limited, so the scale
+ *    doesn't oscillate on noisy timings.
+ *
+ *    Passes can be marked as not scalable: their time still counts
+ *    against the budget, and the scalable passes make up for it. When
+ *    the fixed passes alone are over budget, shrinking the others can't
+ *    recover the time, so they are left as they are.
+ */
+class ResolutionScaler
+{
+public:
+    ResolutionScaler();
+    ~ResolutionScaler();
+
+    void setTarget(double targetFps, float minScale, float maxScale);
+
+    /*
+     * Returns every pass to the maximum scale and forgets all samples.
+     */
+    void reset();
+
+    /*
+     * Called once per frame with the timer's latest results, which must
+     * use the same pass ids as getScale.
+     */
+    void update(const PassTimer &timer);
+
+    float getScale(int passId) const
+      { return scales[passId]; }
+
+    void setScalable(int passId, bool isScalable)
+      { scalable[passId] = isScalable; scales[passId] = maxScale; }
+
+private:
+    friend class ResolutionScalerTests;
+
+    void adjust();
+
+    static constexpr int MAX_PASSES = PassTimer::MAX_PASSES;
+
+    /*
+     * Fraction of the frame period the passes may use; the rest is left
+     * for presentation and anything else sharing the GPU.
+     */
+    static constexpr double BUDGET_FRACTION = 0.9;
+    static constexpr double GROW_THRESHOLD = 0.75; // Of the budget
+    static constexpr double SETTLE_TARGET = 0.85;  // Of the budget
+    static constexpr double CHEAP_PASS_SHARE = 0.1;
+    static constexpr float MAX_SHRINK_STEP = 0.75f;
+    static constexpr float MAX_GROW_STEP = 1.1f;
+
+    /*
+     * Timings reflect the scales from FRAMES_IN_FLIGHT frames ago, so
+     * samples are only taken once a change has worked its way through,
+     * then averaged over SAMPLE_FRAMES.
+     */
+    static constexpr int SETTLE_FRAMES = PassTimer::FRAMES_IN_FLIGHT + 1;
+    static constexpr int SAMPLE_FRAMES = 8;
+
+    float scales[MAX_PASSES];
+    bool scalable[MAX_PASSES];
+    double timeSums[MAX_PASSES];
+    int timeCounts[MAX_PASSES];
+    int framesSinceChange = 0;
+    int numSampleFrames = 0;
+
+    double budget = 1.0 / 60.0 * BUDGET_FRACTION;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResolutionScaler)
+};
@@ -0,0 +1,240 @@
+/*
+  ==============================================================================
+
+    ShaderCompiler.cpp
+    Created: 17 Oct 2026 3:04:18am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ShaderCompiler.h"
+#include "HeadlessContext.h"
+
+ShaderCompiler::ShaderCompiler()
+ : juce::Thread("Shader Compiler")
+{
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    stop();
+}
+
+bool
+ShaderCompiler::start(int numPrograms) // IN
+{
+    stop();
+
+#if JUCE_LINUX || JUCE_WINDOWS
+    juce::String error;
+
+    context.reset(new HeadlessContext());
+    if (!context->createShared(error)) {
+        context.reset();
+        return false;
+    }
+
+    builds.assign((size_t)numPrograms, Build());
+    buildQueued.reset();
+    buildDone.reset();
+
+    // The context may still refuse to be current on another thread
+    threadStarted.reset();
+    startThread();
+    threadStarted.wait(-1);
+    if (!contextCurrent.load()) {
+        stop();
+        return false;
+    }
+
+    running = true;
+    return true;
+#else
+    (void)(numPrograms);
+    return false;
+#endif
+}
+
+void
+ShaderCompiler::stop()
+{
+    if (isThreadRunning()) {
+        signalThreadShouldExit();
+        buildQueued.signal();
+        waitForThreadToExit(-1);
+    }
+
+#if JUCE_LINUX || JUCE_WINDOWS
+    context.reset();
+#endif
+    builds.clear();
+    running = false;
+}
+
+void
+ShaderCompiler::submitBuild(int idx,                            // IN
+                            GLuint program,                     // IN
+                            const juce::String &vertexSource,   // IN
+                            const juce::String &fragmentSource, // IN
+                            bool retrievable)                   // IN
+{
+    {
+        const juce::ScopedLock lock(buildsLock);
+        Build &build = builds[(size_t)idx];
+
+        jassert(build.state == BUILD_IDLE);
+        build.state = BUILD_QUEUED;
+        build.program = program;
+        build.vertexShader = 0;
+        build.fragmentShader = 0;
+        build.vertexSource = vertexSource;
+        build.fragmentSource = fragmentSource;
+        build.retrievable = retrievable;
+    }
+
+    buildQueued.signal();
+}
+
+bool
+ShaderCompiler::takeBuild(int idx,                // IN
+                          GLuint &vertexShader,   // OUT
+                          GLuint &fragmentShader) // OUT
+{
+    const juce::ScopedLock lock(buildsLock);
+    Build &build = builds[(size_t)idx];
+
+    if (build.state != BUILD_DONE) {
+        return false;
+    }
+
+    vertexShader = build.vertexShader;
+    fragmentShader = build.fragmentShader;
+    build = Build();
+    return true;
+}
+
+void
+ShaderCompiler::waitForBuild(int idx,                // IN
+                             GLuint &vertexShader,   // OUT
+                             GLuint &fragmentShader) // OUT
+{
+    while (!takeBuild(idx, vertexShader, fragmentShader)) {
+        buildDone.wait(50);
+    }
+}
+
+void
+ShaderCompiler::cancelBuild(int idx,                // IN
+                            GLuint &vertexShader,   // OUT
+                            GLuint &fragmentShader) // OUT
+{
+    {
+        const juce::ScopedLock lock(buildsLock);
+        Build &build = builds[(size_t)idx];
+
+        if (build.state == BUILD_QUEUED) {
+            build = Build();
+            return;
+        }
+    }
+
+    waitForBuild(idx, vertexShader, fragmentShader);
+}
+
+/*
+ * ShaderCompiler::compile
+ *    Returns with the build complete. Changes made in one context are
+ *    only guaranteed to be seen by another once they have finished, so
+ *    the render thread never sees a half-linked program.
+ */
+void
+ShaderCompiler::compile(Build &build) // IN / OUT
+{
+#if JUCE_LINUX || JUCE_WINDOWS
+    const juce::OpenGLExtensionFunctions &gl = context->getContext().extensions;
+    const GLchar *vertexSourcePtr = build.vertexSource.toRawUTF8();
+    const GLchar *fragmentSourcePtr = build.fragmentSource.toRawUTF8();
+
+    if (build.retrievable && glProgramParameteri != nullptr) {
+        glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    build.vertexShader = gl.glCreateShader(GL_VERTEX_SHADER);
+    gl.glShaderSource(build.vertexShader, 1, &vertexSourcePtr, nullptr);
+    gl.glCompileShader(build.vertexShader);
+
+    build.fragmentShader = gl.glCreateShader(GL_FRAGMENT_SHADER);
+    gl.glShaderSource(build.fragmentShader, 1, &fragmentSourcePtr, nullptr);
+    gl.glCompileShader(build.fragmentShader);
+
+    gl.glAttachShader(build.program, build.vertexShader);
+    gl.glAttachShader(build.program, build.fragmentShader);
+    gl.glLinkProgram(build.program);
+
+    // Blocks here rather than in the render thread's status query
+    GLint status = GL_FALSE;
+    gl.glGetProgramiv(build.program, GL_LINK_STATUS, &status);
+    glFinish();
+#else
+    (void)(build);
+#endif
+}
+
+void
+ShaderCompiler::run()
+{
+#if JUCE_LINUX || JUCE_WINDOWS
+    contextCurrent = context->makeCurrent();
+    if (contextCurrent.load()) {
+        context->getContext().extensions.initialise();
+        glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)
+            juce::OpenGLHelpers::getExtensionFunction("glProgramParameteri");
+    }
+#endif
+    threadStarted.signal();
+
+    if (!contextCurrent.load()) {
+        return;
+    }
+
+    while (!threadShouldExit()) {
+        Build build;
+        int idx = -1;
+
+        {
+            const juce::ScopedLock lock(buildsLock);
+            for (int i = 0; i < (int)builds.size(); i++) {
+                if (builds[(size_t)i].state == BUILD_QUEUED) {
+                    builds[(size_t)i].state = BUILD_RUNNING;
+                    build = builds[(size_t)i];
+                    idx = i;
+                    break;
+                }
+            }
+        }
+
+        if (idx < 0) {
+            buildQueued.wait(50);
+            continue;
+        }
+
+        compile(build);
+
+        {
+            const juce::ScopedLock lock(buildsLock);
+            Build &slot = builds[(size_t)idx];
+            slot.vertexShader = build.vertexShader;
+            slot.fragmentShader = build.fragmentShader;
+            slot.vertexSource = juce::String();
+            slot.fragmentSource = juce::String();
+            slot.state = BUILD_DONE;
+        }
+        buildDone.signal();
+    }
+
+#if JUCE_LINUX || JUCE_WINDOWS
+    context->doneCurrent();
+#endif
+}
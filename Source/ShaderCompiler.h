@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    ShaderCompiler.h
+    Created: 17 Oct 2026 3:04:18am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "glext.h"
+
+class HeadlessContext;
+
+/*
+ * ShaderCompiler
+ *    Compiles and links shader programs on a thread of its own, in a
+ *    context sharing objects with the render context (see
+ *    HeadlessContext::createShared). It stands in for drivers without
+ *    GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile:
+ *    the render thread hands over a program object and its sources,
+ *    keeps rendering, and picks the program up once it has linked.
+ *
+ *    There is one build slot per program. Once submitted, the program
+ *    belongs to the worker until takeBuild, waitForBuild or cancelBuild
+ *    hands it back along with the shaders compiled for it; the render
+ *    thread must not touch either until then. Compile and link status
+ *    and logs are left on the objects, to be queried as usual.
+ */
+class ShaderCompiler : private juce::Thread
+{
+public:
+    ShaderCompiler();
+    ~ShaderCompiler() override;
+
+    /*
+     * Render thread, with the render context current; stop has to be
+     * called from the same thread. start returns false if there is no
+     * way to share the context here, and the caller compiles on the
+     * render thread as before.
+     */
+    bool start(int numPrograms);
+    void stop();
+    bool isRunning() const { return running; }
+
+    /*
+     * retrievable sets GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking.
+     */
+    void submitBuild(int idx, GLuint program, const juce::String &vertexSource,
+                     const juce::String &fragmentSource, bool retrievable);
+    bool takeBuild(int idx, GLuint &vertexShader, GLuint &fragmentShader);
+    void waitForBuild(int idx, GLuint &vertexShader, GLuint &fragmentShader);
+
+    /*
+     * Drops the build for idx, waiting if the worker is partway through
+     * it. Shaders it already compiled are handed back to be deleted.
+     */
+    void cancelBuild(int idx, GLuint &vertexShader, GLuint &fragmentShader);
+
+private:
+    enum BuildState {
+        BUILD_IDLE,
+        BUILD_QUEUED,
+        BUILD_RUNNING,
+        BUILD_DONE
+    };
+
+    struct Build {
+        BuildState state = BUILD_IDLE;
+        GLuint program = 0;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        juce::String vertexSource;
+        juce::String fragmentSource;
+        bool retrievable = false;
+    };
+
+    void run() override;
+    void compile(Build &build);
+
+#if JUCE_LINUX || JUCE_WINDOWS
+    std::unique_ptr<HeadlessContext> context; // Kept out of the header, EGL pulls in X11
+#endif
+    PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = nullptr; // Worker only
+
+    juce::CriticalSection buildsLock;
+    std::vector<Build> builds;
+    juce::WaitableEvent buildQueued;
+    juce::WaitableEvent buildDone;
+
+    juce::WaitableEvent threadStarted;
+    std::atomic<bool> contextCurrent { false };
+    bool running = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ShaderCompiler)
+};
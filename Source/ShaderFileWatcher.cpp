@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    ShaderFileWatcher.cpp
+    Created: 16 Oct 2026 5:20:31pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ShaderFileWatcher.h"
+
+#if JUCE_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+ShaderFileWatcher::ShaderFileWatcher(Listener &listener) // IN
+ :
+#if JUCE_LINUX
+   juce::Thread("Shader file watcher"),
+#endif
+   listener(listener)
+{
+#if JUCE_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0) {
+        startThread();
+    }
+#else
+    startTimer(POLL_INTERVAL_MS);
+#endif
+}
+
+ShaderFileWatcher::~ShaderFileWatcher()
+{
+#if JUCE_LINUX
+    stopThread(2 * POLL_INTERVAL_MS);
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+    }
+#else
+    stopTimer();
+#endif
+    cancelPendingUpdate();
+}
+
+void
+ShaderFileWatcher::setFiles(const juce::StringArray &paths) // IN
+{
+    watchedFiles.clear();
+    for (auto &path : paths) {
+        if (juce::File::isAbsolutePath(path)) {
+            watchedFiles.addIfNotAlreadyThere(juce::File(path).getFullPathName());
+        }
+    }
+
+#if JUCE_LINUX
+    if (inotifyFd < 0) {
+        return;
+    }
+
+    juce::StringArray directories;
+    for (auto &path : watchedFiles) {
+        directories.addIfNotAlreadyThere(juce::File(path).getParentDirectory().getFullPathName());
+    }
+
+    const juce::ScopedLock lock(changedLock);
+
+    for (auto it = watchedDirectories.begin(); it != watchedDirectories.end(); ) {
+        if (!directories.contains(it->second)) {
+            inotify_rm_watch(inotifyFd, it->first);
+            it = watchedDirectories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto &directory : directories) {
+        int wd = inotify_add_watch(inotifyFd, directory.toRawUTF8(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) {
+            watchedDirectories[wd] = directory;
+        }
+    }
+#else
+    std::map<juce::String, juce::Time> times;
+    for (auto &path : watchedFiles) {
+        auto it = modificationTimes.find(path);
+        times[path] = it != modificationTimes.end()
+                    ? it->second
+                    : juce::File(path).getLastModificationTime();
+    }
+    modificationTimes.swap(times);
+#endif
+}
+
+/*
+ * ShaderFileWatcher::handleAsyncUpdate
+ *    Delivers everything collected since the last update. Files that
+ *    were dropped from the watch set in the meantime are ignored.
+ */
+void
+ShaderFileWatcher::handleAsyncUpdate()
+{
+    juce::StringArray changed;
+    {
+        const juce::ScopedLock lock(changedLock);
+        changed.swapWith(changedFiles);
+    }
+
+    for (auto &path : changed) {
+        if (watchedFiles.contains(path)) {
+            listener.shaderFileChanged(path);
+        }
+    }
+}
+
+#if JUCE_LINUX
+
+void
+ShaderFileWatcher::run()
+{
+    alignas(struct inotify_event) char buffer[4096];
+
+    while (!threadShouldExit()) {
+        struct pollfd pfd = { inotifyFd, POLLIN, 0 };
+        if (poll(&pfd, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        bool anyChanged = false;
+
+        const juce::ScopedLock lock(changedLock);
+        for (ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event *event = (const struct inotify_event *)(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            auto it = watchedDirectories.find(event->wd);
+            if (it == watchedDirectories.end() || event->len == 0) {
+                continue;
+            }
+
+            juce::String path = juce::File(it->second).getChildFile(event->name).getFullPathName();
+            changedFiles.addIfNotAlreadyThere(path);
+            anyChanged = true;
+        }
+
+        if (anyChanged) {
+            triggerAsyncUpdate();
+        }
+    }
+}
+
+#else
+
+void
+ShaderFileWatcher::timerCallback()
+{
+    for (auto &entry : modificationTimes) {
+        juce::Time modified = juce::File(entry.first).getLastModificationTime();
+        if (modified != entry.second) {
+            entry.second = modified;
+            changedFiles.addIfNotAlreadyThere(entry.first);
+        }
+    }
+
+    if (!changedFiles.isEmpty()) {
+        handleAsyncUpdate();
+    }
+}
+
+#endif
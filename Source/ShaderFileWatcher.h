@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    ShaderFileWatcher.h
+    Created: 16 Oct 2026 5:20:31pm
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+
+/*
+ * ShaderFileWatcher
+ *    Notices when any of a set of shader files is written. On Linux this
+ *    uses inotify on the containing directories (so editors that save
+ *    by renaming a temp file over the original are caught too); other
+ *    platforms poll modification times. Listener callbacks always happen
+ *    on the message thread, with bursts of writes to the same file
+ *    coalesced into one notification.
+ */
+class ShaderFileWatcher : private juce::AsyncUpdater,
+#if JUCE_LINUX
+                          private juce::Thread
+#else
+                          private juce::Timer
+#endif
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() { }
+        virtual void shaderFileChanged(const juce::String &path) = 0;
+    };
+
+    ShaderFileWatcher(Listener &listener);
+    ~ShaderFileWatcher() override;
+
+    /*
+     * Replaces the set of watched files. Message thread only.
+     */
+    void setFiles(const juce::StringArray &paths);
+
+private:
+    void handleAsyncUpdate() override;
+
+#if JUCE_LINUX
+    void run() override;
+
+    int inotifyFd = -1;
+    std::map<int, juce::String> watchedDirectories; // inotify wd -> directory
+#else
+    void timerCallback() override;
+
+    std::map<juce::String, juce::Time> modificationTimes;
+#endif
+
+    Listener &listener;
+    juce::StringArray watchedFiles;
+
+    juce::CriticalSection changedLock; // Guards changedFiles / watchedDirectories
+    juce::StringArray changedFiles;
+
+    static constexpr int POLL_INTERVAL_MS = 500;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (ShaderFileWatcher)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ShaderFileWatcher)
+};
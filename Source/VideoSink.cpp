@@ -0,0 +1,358 @@
+/*
+  ==============================================================================
+
+    VideoSink.cpp
+    Created: 17 Oct 2026 1:20:44am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "VideoSink.h"
+
+#if JUCE_LINUX || JUCE_MAC
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if JUCE_LINUX || JUCE_MAC
+
+/*
+ * VideoSink::PipeOutputStream
+ *    Writes to a FIFO. FileOutputStream can't: it seeks to the end of
+ *    whatever it opens.
+ */
+class VideoSink::PipeOutputStream : public juce::OutputStream
+{
+public:
+    PipeOutputStream(int fd) : fd(fd) { }
+    ~PipeOutputStream() override { ::close(fd); }
+
+    void flush() override { }
+    bool setPosition(juce::int64) override { return false; }
+    juce::int64 getPosition() override { return position; }
+
+    bool write(const void *data, // IN
+               size_t numBytes)  // IN
+        override
+    {
+        const char *bytes = (const char *)data;
+
+        while (numBytes > 0) {
+            ssize_t written = ::write(fd, bytes, numBytes);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+
+            bytes += written;
+            numBytes -= (size_t)written;
+            position += written;
+        }
+
+        return true;
+    }
+
+private:
+    int fd;
+    juce::int64 position = 0;
+};
+
+#endif // JUCE_LINUX || JUCE_MAC
+
+VideoSink::VideoSink()
+ : juce::Thread("Video Sink")
+{
+}
+
+VideoSink::~VideoSink()
+{
+    juce::String error;
+    close(error);
+}
+
+bool
+VideoSink::isNamedPipe(const juce::File &file) // IN
+{
+#if JUCE_LINUX || JUCE_MAC
+    struct stat info;
+    return stat(file.getFullPathName().toRawUTF8(), &info) == 0 && S_ISFIFO(info.st_mode);
+#else
+    (void)(file);
+    return false;
+#endif
+}
+
+bool
+VideoSink::open(const juce::File &dest, // IN
+                Format fmt,             // IN
+                int w,                  // IN
+                int h,                  // IN
+                double fps,             // IN
+                int capacity,           // IN
+                juce::String &error)    // OUT
+{
+    close(error);
+    error.clear();
+
+    destination = dest;
+    format = fmt;
+    width = w;
+    height = h;
+    frameSize = format == FORMAT_RGBA ? (size_t)width * height * 4
+                                      : YuvConverter::getFrameSize(width, height);
+
+    if (isNamedPipe(destination)) {
+#if JUCE_LINUX || JUCE_MAC
+        // Non-blocking so a pipe with no reader fails instead of hanging
+        int fd = ::open(destination.getFullPathName().toRawUTF8(), O_WRONLY | O_NONBLOCK);
+        if (fd < 0) {
+            error = "Could not open " + destination.getFullPathName() +
+                    (errno == ENXIO ? ": nothing is reading from the pipe"
+                                    : ": " + juce::String(strerror(errno)));
+            return false;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        output.reset(new PipeOutputStream(fd));
+#endif
+    } else {
+        destination.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> file(new juce::FileOutputStream(destination));
+        if (file->failedToOpen()) {
+            error = "Could not open " + destination.getFullPathName() + ": " +
+                    file->getStatus().getErrorMessage();
+            return false;
+        }
+        output = std::move(file);
+    }
+
+    if (format == FORMAT_Y4M) {
+        // Whole frame rates are written as n:1, others to a thousandth
+        int rateNum = (int)std::llround(fps);
+        int rateDen = 1;
+        if (std::abs(fps - rateNum) > 1e-6) {
+            rateNum = (int)std::llround(fps * 1000.0);
+            rateDen = 1000;
+        }
+
+        juce::String header = "YUV4MPEG2 W" + juce::String(width) + " H" + juce::String(height) +
+                              " F" + juce::String(rateNum) + ":" + juce::String(rateDen) +
+                              " Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+        if (!output->write(header.toRawUTF8(), header.getNumBytesAsUTF8())) {
+            error = "Could not write " + destination.getFullPathName();
+            output.reset();
+            return false;
+        }
+    }
+
+    if (format != FORMAT_RGBA && converter == nullptr) {
+        converter.reset(new YuvConverter());
+    }
+
+    const int numFrames = juce::jlimit(MIN_QUEUE_CAPACITY, MAX_QUEUE_CAPACITY, capacity);
+    frames.resize((size_t)numFrames);
+    for (juce::HeapBlock<juce::uint8> &frame : frames) {
+        frame.malloc(frameSize);
+    }
+    fifo.setTotalSize(numFrames + 1);
+    fifo.reset();
+    frameQueued.reset();
+    frameWritten.reset();
+
+    failed = false;
+    failure.clear();
+    queueCapacity = numFrames;
+    maxQueueDepth = 0;
+    framesConverted = 0;
+    framesWritten = 0;
+    numStalls = 0;
+    stallSeconds = 0.0;
+    convertSeconds = 0.0;
+    writeSeconds = 0.0;
+
+    startThread();
+    return true;
+}
+
+/*
+ * VideoSink::pushFrame
+ *    This is where back-pressure lands: with the queue full, the caller
+ *    waits for the writer rather than frames being dropped.
+ */
+bool
+VideoSink::pushFrame(const juce::uint8 *pixels, // IN
+                     juce::String &error)       // OUT
+{
+    jassert(isOpen());
+
+    if (fifo.getFreeSpace() == 0 && !failed.load()) {
+        juce::int64 waitStart = juce::Time::getHighResolutionTicks();
+
+        while (fifo.getFreeSpace() == 0 && !failed.load()) {
+            frameWritten.wait(50);
+        }
+
+        numStalls++;
+        stallSeconds = stallSeconds.load() +
+            juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - waitStart);
+    }
+
+    if (failed.load()) {
+        const juce::ScopedLock lock(failureLock);
+        error = failure;
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    jassert(size1 == 1);
+
+    juce::int64 convertStart = juce::Time::getHighResolutionTicks();
+    convertFrame(pixels, frames[(size_t)start1].get());
+    convertSeconds = convertSeconds.load() +
+        juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - convertStart);
+    framesConverted++;
+
+    fifo.finishedWrite(1);
+    frameQueued.signal();
+
+    int depth = fifo.getNumReady();
+    if (depth > maxQueueDepth.load()) {
+        maxQueueDepth = depth;
+    }
+
+    return true;
+}
+
+void
+VideoSink::convertFrame(const juce::uint8 *pixels, // IN
+                        juce::uint8 *dst)          // OUT
+{
+    if (format == FORMAT_RGBA) {
+        const size_t rowBytes = (size_t)width * 4;
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + (size_t)y * rowBytes, pixels + (size_t)(height - 1 - y) * rowBytes, rowBytes);
+        }
+        return;
+    }
+
+    converter->convert(pixels, width, height,
+                       format == FORMAT_NV12 ? YuvConverter::LAYOUT_NV12
+                                             : YuvConverter::LAYOUT_I420,
+                       dst);
+}
+
+bool
+VideoSink::close(juce::String &error) // OUT
+{
+    if (output == nullptr) {
+        return true;
+    }
+
+    // The writer drains the queue before it exits
+    signalThreadShouldExit();
+    frameQueued.signal();
+    waitForThreadToExit(-1);
+
+    output->flush();
+    output.reset();
+
+    if (failed.load()) {
+        const juce::ScopedLock lock(failureLock);
+        error = failure;
+        return false;
+    }
+
+    return true;
+}
+
+VideoSink::Stats
+VideoSink::getStats() const
+{
+    Stats stats;
+    stats.queueCapacity = queueCapacity.load();
+    stats.queueDepth = fifo.getNumReady();
+    stats.maxQueueDepth = maxQueueDepth.load();
+    stats.framesWritten = framesWritten.load();
+    stats.numStalls = numStalls.load();
+    stats.stallSeconds = stallSeconds.load();
+
+    int converted = framesConverted.load();
+    if (converted > 0) {
+        stats.convertMs = 1000.0 * convertSeconds.load() / converted;
+    }
+    if (stats.framesWritten > 0) {
+        stats.writeMs = 1000.0 * writeSeconds.load() / stats.framesWritten;
+    }
+
+    return stats;
+}
+
+void
+VideoSink::setFailed(const juce::String &error) // IN
+{
+    {
+        const juce::ScopedLock lock(failureLock);
+        failure = error;
+    }
+
+    failed = true;
+    frameWritten.signal();
+}
+
+/*
+ * VideoSink::run
+ *    Writes queued frames in order until told to exit with the queue
+ *    empty. After a failed write the rest are discarded so the producer
+ *    never waits on a dead output.
+ */
+void
+VideoSink::run()
+{
+#if JUCE_LINUX || JUCE_MAC
+    // A reader closing its end of the pipe should fail the write, not
+    // kill the host with SIGPIPE
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+#endif
+
+    for (;;) {
+        if (fifo.getNumReady() == 0) {
+            if (threadShouldExit()) {
+                break;
+            }
+            frameQueued.wait(50);
+            continue;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+        jassert(size1 == 1);
+
+        if (!failed.load()) {
+            juce::int64 writeStart = juce::Time::getHighResolutionTicks();
+
+            bool written = format != FORMAT_Y4M || output->write("FRAME\n", 6);
+            written = written && output->write(frames[(size_t)start1].get(), frameSize);
+            if (written) {
+                writeSeconds = writeSeconds.load() +
+                    juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - writeStart);
+                framesWritten++;
+            } else {
+                setFailed("Could not write " + destination.getFullPathName());
+            }
+        }
+
+        fifo.finishedRead(1);
+        frameWritten.signal();
+    }
+}
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    VideoSink.h
+    Created: 17 Oct 2026 1:20:44am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "YuvConverter.h"
+
+/*
+ * VideoSink
+ *    Streams exported frames to a file or a named pipe (a FIFO made with
+ *    mkfifo, read by an encoder such as ffmpeg), as YUV4MPEG2 (.y4m,
+ *    4:2:0), headerless I420 or NV12, or headerless RGBA8.
+ *
+ *    pushFrame converts a frame straight from the readback buffer into
+ *    a bounded queue, with YUV conversion spread over a thread pool;
+ *    a writer thread drains the queue to the output. When the output
+ *    can't keep up (a slow encoder on the other end of a pipe) the
+ *    queue fills and pushFrame waits, which holds up readback and, in
+ *    turn, rendering. How often and for how long that happens is kept
+ *    in the statistics.
+ */
+class VideoSink : private juce::Thread
+{
+public:
+    enum Format {
+        FORMAT_Y4M,
+        FORMAT_I420,
+        FORMAT_NV12,
+        FORMAT_RGBA
+    };
+
+    struct Stats
+    {
+        int queueCapacity = 0;
+        int queueDepth = 0;       // Frames converted but not yet written
+        int maxQueueDepth = 0;
+        int framesWritten = 0;
+        int numStalls = 0;        // Pushes that had to wait for queue space
+        double stallSeconds = 0.0;
+        double convertMs = 0.0;   // Average per frame
+        double writeMs = 0.0;     // Average per frame
+    };
+
+    VideoSink();
+    ~VideoSink() override;
+
+    /*
+     * A destination that is a FIFO is opened without truncating it, and
+     * fails straight away if nothing has it open for reading.
+     */
+    bool open(const juce::File &destination, Format format, int width, int height,
+              double fps, int queueCapacity, juce::String &error);
+
+    /*
+     * pixels are RGBA8, bottom row first, width x height. Returns false
+     * once the output has failed.
+     */
+    bool pushFrame(const juce::uint8 *pixels, juce::String &error);
+
+    /*
+     * Writes out everything queued and closes the output. Returns false
+     * with a reason in error if any write failed.
+     */
+    bool close(juce::String &error);
+
+    bool isOpen() const { return output != nullptr; }
+
+    /*
+     * Any thread.
+     */
+    Stats getStats() const;
+
+    static bool isNamedPipe(const juce::File &file);
+
+    static constexpr int MIN_QUEUE_CAPACITY = 2;
+    static constexpr int MAX_QUEUE_CAPACITY = 16;
+    static constexpr int DEFAULT_QUEUE_CAPACITY = 4;
+
+private:
+    class PipeOutputStream;
+
+    void run() override;
+    void convertFrame(const juce::uint8 *pixels, juce::uint8 *dst);
+    void setFailed(const juce::String &error);
+
+    juce::File destination;
+    Format format = FORMAT_Y4M;
+    int width = 0;
+    int height = 0;
+    size_t frameSize = 0;
+    std::unique_ptr<juce::OutputStream> output;
+    std::unique_ptr<YuvConverter> converter; // Created on first YUV open, kept after
+
+    /*
+     * Single producer (pushFrame), single consumer (run). The fifo has
+     * one more slot than the queue since it never fills completely.
+     */
+    std::vector<juce::HeapBlock<juce::uint8>> frames;
+    juce::AbstractFifo fifo { 1 };
+    juce::WaitableEvent frameQueued;
+    juce::WaitableEvent frameWritten;
+
+    std::atomic<bool> failed { false };
+    juce::String failure;
+    juce::CriticalSection failureLock;
+
+    std::atomic<int> queueCapacity { 0 };
+    std::atomic<int> maxQueueDepth { 0 };
+    std::atomic<int> framesConverted { 0 };
+    std::atomic<int> framesWritten { 0 };
+    std::atomic<int> numStalls { 0 };
+    std::atomic<double> stallSeconds { 0.0 };
+    std::atomic<double> convertSeconds { 0.0 };
+    std::atomic<double> writeSeconds { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VideoSink)
+};
@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+    YuvConverter.cpp
+    Created: 17 Oct 2026 12:52:36am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "YuvConverter.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+#include <emmintrin.h>
+#endif
+
+/*
+ * BT.709 limited range in 8.8 fixed point. Each chroma row sums to 0 so
+ * grey stays exactly at 128.
+ */
+static constexpr int Y_R = 47, Y_G = 157, Y_B = 16;
+static constexpr int U_R = -26, U_G = -86, U_B = 112;
+static constexpr int V_R = 112, V_G = -102, V_B = -10;
+
+static inline juce::uint8
+lumaOf(const juce::uint8 *px) // IN
+{
+    return (juce::uint8)(((Y_R * px[0] + Y_G * px[1] + Y_B * px[2] + 128) >> 8) + 16);
+}
+
+/*
+ * YuvConverter::BandJob
+ *    Converts one band of chroma rows (two luma rows each).
+ */
+class YuvConverter::BandJob : public juce::ThreadPoolJob
+{
+public:
+    BandJob() : juce::ThreadPoolJob("YUV Band") { }
+
+    JobStatus runJob() override
+    {
+        convertRows(rgba, width, height, layout, dst, firstChromaRow, endChromaRow);
+        return jobHasFinished;
+    }
+
+    const juce::uint8 *rgba = nullptr;
+    int width = 0;
+    int height = 0;
+    Layout layout = LAYOUT_I420;
+    juce::uint8 *dst = nullptr;
+    int firstChromaRow = 0;
+    int endChromaRow = 0;
+};
+
+YuvConverter::YuvConverter(int numThreads) // IN
+ : pool(numThreads > 0 ? numThreads : juce::jmax(1, juce::SystemStats::getNumCpus() - 1))
+{
+    for (int i = 0; i < pool.getNumThreads(); i++) {
+        jobs.emplace_back(new BandJob());
+    }
+}
+
+YuvConverter::~YuvConverter()
+{
+    pool.removeAllJobs(false, 10000);
+}
+
+size_t
+YuvConverter::getFrameSize(int width,  // IN
+                           int height) // IN
+{
+    size_t chromaSize = (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    return (size_t)width * height + 2 * chromaSize;
+}
+
+/*
+ * YuvConverter::convert
+ *    The caller converts the last band itself rather than sitting idle
+ *    while the pool works.
+ */
+void
+YuvConverter::convert(const juce::uint8 *rgba, // IN
+                      int width,               // IN
+                      int height,              // IN
+                      Layout layout,           // IN
+                      juce::uint8 *dst)        // OUT
+{
+    const int chromaHeight = (height + 1) / 2;
+    const int numBands = juce::jlimit(1, (int)jobs.size() + 1,
+                                      chromaHeight / MIN_BAND_CHROMA_ROWS);
+    const int rowsPerBand = (chromaHeight + numBands - 1) / numBands;
+
+    for (int i = 0; i < numBands - 1; i++) {
+        BandJob &job = *jobs[i];
+        job.rgba = rgba;
+        job.width = width;
+        job.height = height;
+        job.layout = layout;
+        job.dst = dst;
+        job.firstChromaRow = i * rowsPerBand;
+        job.endChromaRow = juce::jmin(chromaHeight, (i + 1) * rowsPerBand);
+        pool.addJob(&job, false);
+    }
+
+    convertRows(rgba, width, height, layout, dst,
+                juce::jmin(chromaHeight, (numBands - 1) * rowsPerBand), chromaHeight);
+
+    for (int i = 0; i < numBands - 1; i++) {
+        pool.waitForJobToFinish(jobs[i].get(), -1);
+    }
+}
+
+void
+YuvConverter::convertRows(const juce::uint8 *rgba, // IN
+                          int width,               // IN
+                          int height,              // IN
+                          Layout layout,           // IN
+                          juce::uint8 *dst,        // OUT
+                          int firstChromaRow,      // IN
+                          int endChromaRow)        // IN
+{
+    const size_t rowBytes = (size_t)width * 4;
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    juce::uint8 *yPlane = dst;
+    juce::uint8 *chromaPlanes = dst + (size_t)width * height;
+    const int chromaStep = layout == LAYOUT_NV12 ? 2 : 1;
+
+    for (int cy = firstChromaRow; cy < endChromaRow; cy++) {
+        // An odd last row pairs with itself
+        int y0 = 2 * cy;
+        int y1 = juce::jmin(y0 + 1, height - 1);
+        const juce::uint8 *src0 = rgba + (size_t)(height - 1 - y0) * rowBytes;
+        const juce::uint8 *src1 = rgba + (size_t)(height - 1 - y1) * rowBytes;
+
+        juce::uint8 *u, *v;
+        if (layout == LAYOUT_NV12) {
+            u = chromaPlanes + (size_t)cy * chromaWidth * 2;
+            v = u + 1;
+        } else {
+            u = chromaPlanes + (size_t)cy * chromaWidth;
+            v = chromaPlanes + (size_t)chromaWidth * chromaHeight + (size_t)cy * chromaWidth;
+        }
+
+        for (int row = y0; row <= y1; row++) {
+            const juce::uint8 *src = row == y0 ? src0 : src1;
+            juce::uint8 *yRow = yPlane + (size_t)row * width;
+
+            for (int x = convertLumaRowSimd(src, yRow, width); x < width; x++) {
+                yRow[x] = lumaOf(src + x * 4);
+            }
+        }
+
+        for (int cx = convertChromaRowSimd(src0, src1, u, v, width, layout); cx < chromaWidth; cx++) {
+            // An odd last column pairs with itself
+            int x0 = 2 * cx;
+            int x1 = juce::jmin(x0 + 1, width - 1);
+            int r = src0[x0 * 4 + 0] + src0[x1 * 4 + 0] + src1[x0 * 4 + 0] + src1[x1 * 4 + 0];
+            int g = src0[x0 * 4 + 1] + src0[x1 * 4 + 1] + src1[x0 * 4 + 1] + src1[x1 * 4 + 1];
+            int b = src0[x0 * 4 + 2] + src0[x1 * 4 + 2] + src1[x0 * 4 + 2] + src1[x1 * 4 + 2];
+
+            u[cx * chromaStep] = (juce::uint8)(((U_R * r + U_G * g + U_B * b + 512) >> 10) + 128);
+            v[cx * chromaStep] = (juce::uint8)(((V_R * r + V_G * g + V_B * b + 512) >> 10) + 128);
+        }
+    }
+}
+
+#if JUCE_USE_SSE_INTRINSICS
+
+/*
+ * Adds the 32-bit lanes of a and b pairwise: [a0+a1, a2+a3, b0+b1, b2+b3].
+ */
+static inline __m128i
+addPairs(__m128i a, // IN
+         __m128i b) // IN
+{
+    __m128 evens = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odds = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1));
+    return _mm_add_epi32(_mm_castps_si128(evens), _mm_castps_si128(odds));
+}
+
+/*
+ * Four RGBA pixels from each of two rows in, RGBA sums of the 2x2
+ * blocks of pixels 0+1 and 2+3 as 16-bit lanes out. Sums are at most
+ * 4 * 255, so nothing is lost.
+ */
+static inline __m128i
+sumPixelBlocks(__m128i px0, // IN
+               __m128i px1) // IN
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(px0, zero), _mm_unpacklo_epi8(px1, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(px0, zero), _mm_unpackhi_epi8(px1, zero));
+    return _mm_unpacklo_epi64(_mm_add_epi16(lo, _mm_srli_si128(lo, 8)),
+                              _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+}
+
+/*
+ * YuvConverter::convertLumaRowSimd
+ *    16 pixels per iteration: each pixel's RGBA widened to 16 bits,
+ *    multiplied against the coefficients with madd, and the two partial
+ *    sums per pixel added. Returns the number of pixels done.
+ */
+int
+YuvConverter::convertLumaRowSimd(const juce::uint8 *src, // IN
+                                 juce::uint8 *dst,       // OUT
+                                 int width)              // IN
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i coef = _mm_setr_epi16(Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i offset = _mm_set1_epi32(16);
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i luma[4];
+
+        for (int k = 0; k < 4; k++) {
+            __m128i px = _mm_loadu_si128((const __m128i *)(src + (x + 4 * k) * 4));
+            __m128i sums = addPairs(_mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coef),
+                                    _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coef));
+            luma[k] = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sums, round), 8), offset);
+        }
+
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_packus_epi16(_mm_packs_epi32(luma[0], luma[1]),
+                                          _mm_packs_epi32(luma[2], luma[3])));
+    }
+
+    return x;
+}
+
+/*
+ * YuvConverter::convertChromaRowSimd
+ *    16 pixels (8 chroma samples) per iteration. Each 2x2 block is
+ *    summed in 16-bit lanes and converted exactly as the scalar loop
+ *    does, so both give the same bytes. Returns the number of chroma
+ *    samples done.
+ */
+int
+YuvConverter::convertChromaRowSimd(const juce::uint8 *src0, // IN
+                                   const juce::uint8 *src1, // IN
+                                   juce::uint8 *u,          // OUT
+                                   juce::uint8 *v,          // OUT
+                                   int width,               // IN
+                                   Layout layout)           // IN
+{
+    const __m128i coefU = _mm_setr_epi16(U_R, U_G, U_B, 0, U_R, U_G, U_B, 0);
+    const __m128i coefV = _mm_setr_epi16(V_R, V_G, V_B, 0, V_R, V_G, V_B, 0);
+    const __m128i round = _mm_set1_epi32(512);
+    const __m128i offset = _mm_set1_epi32(128);
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i chromaU[2], chromaV[2];
+
+        for (int k = 0; k < 2; k++) {
+            const int p = (x + 8 * k) * 4;
+            __m128i blocks0 = sumPixelBlocks(_mm_loadu_si128((const __m128i *)(src0 + p)),
+                                             _mm_loadu_si128((const __m128i *)(src1 + p)));
+            __m128i blocks1 = sumPixelBlocks(_mm_loadu_si128((const __m128i *)(src0 + p + 16)),
+                                             _mm_loadu_si128((const __m128i *)(src1 + p + 16)));
+
+            __m128i sumU = addPairs(_mm_madd_epi16(blocks0, coefU), _mm_madd_epi16(blocks1, coefU));
+            __m128i sumV = addPairs(_mm_madd_epi16(blocks0, coefV), _mm_madd_epi16(blocks1, coefV));
+            chromaU[k] = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sumU, round), 10), offset);
+            chromaV[k] = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sumV, round), 10), offset);
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+        __m128i u8 = _mm_packus_epi16(_mm_packs_epi32(chromaU[0], chromaU[1]), zero);
+        __m128i v8 = _mm_packus_epi16(_mm_packs_epi32(chromaV[0], chromaV[1]), zero);
+
+        if (layout == LAYOUT_NV12) {
+            _mm_storeu_si128((__m128i *)(u + x), _mm_unpacklo_epi8(u8, v8));
+        } else {
+            _mm_storel_epi64((__m128i *)(u + x / 2), u8);
+            _mm_storel_epi64((__m128i *)(v + x / 2), v8);
+        }
+    }
+
+    return x / 2;
+}
+
+#else
+
+int
+YuvConverter::convertLumaRowSimd(const juce::uint8 *src, // IN
+                                 juce::uint8 *dst,       // OUT
+                                 int width)              // IN
+{
+    (void)(src);
+    (void)(dst);
+    (void)(width);
+    return 0;
+}
+
+int
+YuvConverter::convertChromaRowSimd(const juce::uint8 *src0, // IN
+                                   const juce::uint8 *src1, // IN
+                                   juce::uint8 *u,          // OUT
+                                   juce::uint8 *v,          // OUT
+                                   int width,               // IN
+                                   Layout layout)           // IN
+{
+    (void)(src0);
+    (void)(src1);
+    (void)(u);
+    (void)(v);
+    (void)(width);
+    (void)(layout);
+    return 0;
+}
+
+#endif // JUCE_USE_SSE_INTRINSICS
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    YuvConverter.h
+    Created: 17 Oct 2026 12:52:36am
+    Author:  Austin Borger, aaborger@gmail.com
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ * YuvConverter
+ *    Converts RGBA8 frames, bottom row first as glReadPixels returns
+ *    them, to 8-bit YUV 4:2:0 (BT.709, limited range, chroma averaged
+ *    over each 2x2 block), top row first, which is what video encoders
+ *    take. Rows are done with SSE2 where available and scalar code
+ *    elsewhere and for the ends of rows. A frame is split into bands of
+ *    rows converted in parallel on a thread pool plus the caller.
+ *
+ *    Output is tightly packed: the Y plane, then either separate U and
+ *    V planes (I420) or one interleaved UV plane (NV12), each chroma
+ *    plane (width + 1) / 2 x (height + 1) / 2.
+ */
+class YuvConverter
+{
+public:
+    enum Layout {
+        LAYOUT_I420,
+        LAYOUT_NV12
+    };
+
+    /*
+     * numThreads is the number of pool threads besides the caller; 0
+     * picks one per core.
+     */
+    YuvConverter(int numThreads = 0);
+    ~YuvConverter();
+
+    void convert(const juce::uint8 *rgba, int width, int height, Layout layout,
+                 juce::uint8 *dst);
+
+    static size_t getFrameSize(int width, int height);
+
+private:
+    class BandJob;
+
+    static void convertRows(const juce::uint8 *rgba, int width, int height, Layout layout,
+                            juce::uint8 *dst, int firstChromaRow, int endChromaRow);
+    static int convertLumaRowSimd(const juce::uint8 *src, juce::uint8 *dst, int width);
+    static int convertChromaRowSimd(const juce::uint8 *src0, const juce::uint8 *src1,
+                                    juce::uint8 *u, juce::uint8 *v, int width, Layout layout);
+
+    /*
+     * Bands smaller than this aren't worth a thread hand-off.
+     */
+    static constexpr int MIN_BAND_CHROMA_ROWS = 16;
+
+    juce::ThreadPool pool;
+    std::vector<std::unique_ptr<BandJob>> jobs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (YuvConverter)
+};